@@ -0,0 +1,264 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catalogue_service.h"
+#include "city_generator.h"
+#include "json_compact.h"
+#include "request_handler.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchSettings{
+    transport_catalogue::bench::CitySettings city;
+    std::vector<size_t> end_to_end_stops{1000, 100000, 1000000};
+    double min_time = 0.5;
+};
+
+class NullBuffer : public std::streambuf{
+protected:
+    int_type overflow(int_type ch) override{
+        return traits_type::not_eof(ch);
+    }
+    std::streamsize xsputn(const char*, std::streamsize count) override{
+        return count;
+    }
+};
+
+template <typename T>
+void DoNotOptimize(const T& value){
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+void PrintUsage(std::ostream& out){
+    out << "Usage:\n"
+           "  bench [city options] [--end-to-end <stops,stops,...>] [--min-time <seconds>]\n"
+           "  bench --generate (city | log) [city options]\n"
+           "City options: [--stops <count>] [--buses <count>] [--route-stops <count>] [--distances <per stop>]\n"
+           "              [--requests <count>] [--zipf <exponent>] [--bus-share <share>] [--map-share <share>]\n"
+           "              [--seed <seed>]\n";
+}
+
+// итерации удваиваются, пока суммарное время не превысит min_time
+template <typename F>
+void Measure(const std::string& name, double min_time, F&& f){
+    size_t iterations = 0;
+    size_t batch = 1;
+    std::chrono::duration<double> elapsed{0};
+    auto start = Clock::now();
+    while(elapsed.count() < min_time){
+        for(size_t i = 0; i < batch; ++i){
+            f();
+        }
+        iterations += batch;
+        batch *= 2;
+        elapsed = Clock::now() - start;
+    }
+    double ns_per_op = elapsed.count() * 1e9 / static_cast<double>(iterations);
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(12) << iterations << " it"s
+              << std::setw(16) << std::fixed << std::setprecision(1) << ns_per_op << " ns/op"s
+              << std::setw(16) << std::setprecision(0) << 1e9 / ns_per_op << " op/s"s << std::endl;
+}
+
+std::string GenerateCityText(const transport_catalogue::bench::CitySettings& settings){
+    std::ostringstream output;
+    transport_catalogue::bench::WriteCity(settings, output);
+    return output.str();
+}
+
+void RunMicrobenchmarks(const BenchSettings& settings){
+    const std::string text = GenerateCityText(settings.city);
+    std::cout << "microbenchmarks: "s << settings.city.stops << " stops, "s << settings.city.buses << " buses, "s
+              << text.size() << " bytes of input"s << std::endl;
+
+    Measure("json::Load"s, settings.min_time, [&text]{
+        std::istringstream input(text);
+        DoNotOptimize(json::Load(input));
+    });
+    Measure("json::compact::Load"s, settings.min_time, [&text]{
+        DoNotOptimize(json::compact::Load(text));
+    });
+
+    const json::compact::Document document = json::compact::Load(text);
+    Measure("CreateDb"s, settings.min_time, [&document]{
+        transport_catalogue::TransportCatalogue catalogue;
+        transport_catalogue::input::JSONReader reader(catalogue);
+        reader.CreateDb(document.GetRoot().At("base_requests"));
+        DoNotOptimize(catalogue);
+    });
+
+    const transport_catalogue::CatalogueService service(document);
+    const auto snapshot = service.GetCatalogue();
+    const transport_catalogue::TransportCatalogue& catalogue = *snapshot;
+
+    std::vector<std::string> bus_names;
+    std::vector<std::string> stop_names;
+    for(const json::compact::Value& query : document.GetRoot().At("stat_requests")){
+        std::string_view type = query.At("type").AsString();
+        if(type == "Bus"){
+            bus_names.emplace_back(query.At("name").AsString());
+        }else if(type == "Stop"){
+            stop_names.emplace_back(query.At("name").AsString());
+        }
+    }
+    std::vector<std::pair<std::string, std::string>> stop_pairs;
+    for(const auto& bus : catalogue.GetAllBuses()){
+        for(size_t i = 1; bus && i < bus->stops.size(); ++i){
+            stop_pairs.emplace_back(bus->stops[i - 1]->stopname, bus->stops[i]->stopname);
+        }
+    }
+
+    if(!bus_names.empty()){
+        size_t next = 0;
+        Measure("GetBusInfo"s, settings.min_time, [&]{
+            DoNotOptimize(catalogue.GetBusInfo(bus_names[next++ % bus_names.size()]));
+        });
+    }
+    if(!stop_names.empty()){
+        size_t next = 0;
+        Measure("GetStopInfo"s, settings.min_time, [&]{
+            const std::string& name = stop_names[next++ % stop_names.size()];
+            if(catalogue.IsExistingStop(name)){
+                DoNotOptimize(catalogue.GetStopInfo(name));
+            }
+        });
+    }
+    if(!bus_names.empty()){
+        size_t next = 0;
+        Measure("FindBus"s, settings.min_time, [&]{
+            DoNotOptimize(catalogue.FindBus(bus_names[next++ % bus_names.size()]));
+        });
+    }
+    if(!stop_names.empty()){
+        size_t next = 0;
+        Measure("FindStop"s, settings.min_time, [&]{
+            DoNotOptimize(catalogue.FindStop(stop_names[next++ % stop_names.size()]));
+        });
+    }
+    if(!stop_pairs.empty()){
+        size_t next = 0;
+        Measure("GetDistance"s, settings.min_time, [&]{
+            const auto& [from, to] = stop_pairs[next++ % stop_pairs.size()];
+            DoNotOptimize(catalogue.GetDistance(from, to));
+        });
+    }
+
+    const std::set<Bus> buses = GetBusesOnRoute(catalogue);
+    Measure("DrawMap"s, settings.min_time, [&]{
+        DoNotOptimize(service.GetRenderer().DrawMap(buses));
+    });
+    const svg::Document map = service.GetRenderer().DrawMap(buses);
+    NullBuffer null_buffer;
+    std::ostream null_output(&null_buffer);
+    Measure("svg::Document::Render"s, settings.min_time, [&]{
+        map.Render(null_output);
+    });
+}
+
+void RunEndToEnd(const BenchSettings& settings){
+    std::cout << "end to end:"s << std::endl;
+    for(size_t stops : settings.end_to_end_stops){
+        transport_catalogue::bench::CitySettings city = settings.city;
+        city.stops = stops;
+        city.buses = std::max<size_t>(stops / 10, 1);
+        const std::string text = GenerateCityText(city);
+
+        NullBuffer null_buffer;
+        std::ostream null_output(&null_buffer);
+        auto start = Clock::now();
+        std::istringstream input(text);
+        transport_catalogue::CatalogueService service(input);
+        auto built = Clock::now();
+        service.PrintResponse(null_output);
+        auto answered = Clock::now();
+
+        std::chrono::duration<double> build_time = built - start;
+        std::chrono::duration<double> answer_time = answered - built;
+        std::cout << std::left << std::setw(10) << stops << std::right << " stops: "s
+                  << std::fixed << std::setprecision(3) << "build "s << build_time.count() << " s ("s
+                  << std::setprecision(0) << static_cast<double>(text.size()) / build_time.count() / 1e6 << " MB/s), "s
+                  << city.stat_requests << " requests in "s << std::setprecision(3) << answer_time.count() << " s ("s
+                  << std::setprecision(0) << static_cast<double>(city.stat_requests) / answer_time.count() << " req/s)"s
+                  << std::endl;
+    }
+}
+
+std::vector<size_t> ParseSizes(const std::string& value){
+    std::vector<size_t> result;
+    std::istringstream input(value);
+    for(std::string item; std::getline(input, item, ',');){
+        result.push_back(std::stoul(item));
+    }
+    return result;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    BenchSettings settings;
+    settings.city.stops = 10000;
+    settings.city.buses = 1000;
+    settings.city.stat_requests = 10000;
+    // карта на крупных городах рендерится секундами и заслонила бы остальные запросы; DrawMap меряется отдельно
+    settings.city.map_share = 0;
+    std::string generate;
+    for(int i = 1; i + 1 < argc; i += 2){
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if(arg == "--generate"s){
+            generate = value;
+        }else if(arg == "--stops"s){
+            settings.city.stops = std::stoul(value);
+        }else if(arg == "--buses"s){
+            settings.city.buses = std::stoul(value);
+        }else if(arg == "--route-stops"s){
+            settings.city.stops_per_route = std::stoul(value);
+        }else if(arg == "--distances"s){
+            settings.city.distances_per_stop = std::stoul(value);
+        }else if(arg == "--requests"s){
+            settings.city.stat_requests = std::stoul(value);
+        }else if(arg == "--zipf"s){
+            settings.city.zipf_exponent = std::stod(value);
+        }else if(arg == "--bus-share"s){
+            settings.city.bus_share = std::stod(value);
+        }else if(arg == "--map-share"s){
+            settings.city.map_share = std::stod(value);
+        }else if(arg == "--seed"s){
+            settings.city.seed = std::stoull(value);
+        }else if(arg == "--end-to-end"s){
+            settings.end_to_end_stops = ParseSizes(value);
+        }else if(arg == "--min-time"s){
+            settings.min_time = std::stod(value);
+        }else{
+            PrintUsage(std::cerr);
+            return 1;
+        }
+    }
+    if(argc % 2 == 0 || (!generate.empty() && generate != "city"s && generate != "log"s)){
+        PrintUsage(std::cerr);
+        return 1;
+    }
+
+    if(generate == "city"s){
+        transport_catalogue::bench::WriteCity(settings.city, std::cout);
+        return 0;
+    }
+    if(generate == "log"s){
+        transport_catalogue::bench::WriteRequestLog(settings.city, std::cout);
+        return 0;
+    }
+
+    RunMicrobenchmarks(settings);
+    RunEndToEnd(settings);
+}
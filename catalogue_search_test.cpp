@@ -0,0 +1,75 @@
+#include "transport_catalogue.h"
+#include "test_check.h"
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using transport_catalogue::TransportCatalogue;
+
+bool HasPrefixMatch(const name_search::NameIndex& index, std::string_view prefix, std::string_view name) {
+    std::vector<std::string_view> names = index.FindByPrefix(prefix, 100);
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+bool HasSimilarMatch(const name_search::NameIndex& index, std::string_view query, std::string_view name) {
+    for (const name_search::NameIndex::Match& match : index.FindSimilar(query, 100)) {
+        if (match.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FillCatalogue(TransportCatalogue& catalogue) {
+    catalogue.AddStop("Airport", {55.60, 37.20});
+    catalogue.AddStop("Airfield", {55.61, 37.21});
+    catalogue.AddStop("Harbour", {55.62, 37.22});
+    catalogue.AddBus("Air 1", std::vector<std::string_view>{"Airport", "Harbour"}, false);
+    catalogue.AddBus("Air 2", std::vector<std::string_view>{"Harbour", "Airport"}, false);
+    catalogue.Freeze();
+}
+
+// удалённая остановка не должна находиться ни по префиксу, ни по опечатке, ни по точному имени
+void TestRemovedStopIsNotFound() {
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue);
+    TC_CHECK(HasPrefixMatch(catalogue.GetStopNameIndex(), "Air", "Airfield"));
+
+    catalogue.RemoveStop("Airfield");
+    TC_CHECK(!catalogue.IsFrozen());
+    TC_CHECK(catalogue.FindStop("Airfield") == nullptr);
+    catalogue.Freeze();
+
+    TC_CHECK(catalogue.FindStop("Airfield") == nullptr);
+    TC_CHECK(catalogue.FindStop("Airport") != nullptr);
+    TC_CHECK(!HasPrefixMatch(catalogue.GetStopNameIndex(), "Air", "Airfield"));
+    TC_CHECK(HasPrefixMatch(catalogue.GetStopNameIndex(), "Air", "Airport"));
+    TC_CHECK(!HasSimilarMatch(catalogue.GetStopNameIndex(), "Airfeld", "Airfield"));
+}
+
+void TestRemovedBusIsNotFound() {
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue);
+    TC_CHECK(HasSimilarMatch(catalogue.GetBusNameIndex(), "Air 3", "Air 2"));
+
+    catalogue.RemoveBus("Air 2");
+    TC_CHECK(!catalogue.IsFrozen());
+    catalogue.Freeze();
+
+    TC_CHECK(catalogue.FindBus("Air 2") == nullptr);
+    TC_CHECK(catalogue.FindBus("Air 1") != nullptr);
+    TC_CHECK(!HasPrefixMatch(catalogue.GetBusNameIndex(), "Air", "Air 2"));
+    TC_CHECK(HasPrefixMatch(catalogue.GetBusNameIndex(), "Air", "Air 1"));
+    TC_CHECK(!HasSimilarMatch(catalogue.GetBusNameIndex(), "Air 3", "Air 2"));
+}
+
+}
+
+int main() {
+    TestRemovedStopIsNotFound();
+    TestRemovedBusIsNotFound();
+    std::cout << "catalogue_search_test: OK" << std::endl;
+}
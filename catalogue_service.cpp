@@ -0,0 +1,81 @@
+#include "catalogue_service.h"
+#include "compression.h"
+#include "instrumentation.h"
+#include "response_fragments.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <optional>
+#include <thread>
+
+namespace transport_catalogue{
+
+namespace {
+
+// base_requests не переводится в json::Node: каталог строится прямо из компактного документа
+json::Dict ToDictWithoutBaseRequests(const json::compact::Value& root){
+    json::Dict result;
+    for(auto it = root.MembersBegin(); it != root.MembersEnd(); ++it){
+        if(it->key != "base_requests"){
+            result.insert({std::string(it->key), json::compact::ToNode(it->value)});
+        }
+    }
+    return result;
+}
+
+// сжатый вход распаковывается потоково прямо в буфер разбора
+json::compact::Document LoadDocument(std::istream& input){
+    TC_SCOPED_TIMER(PARSE);
+    TC_TRACE_SCOPE("json_load");
+    compression::InputStream decompressed(input);
+    return json::compact::Load(decompressed, {std::max(1u, std::thread::hardware_concurrency())});
+}
+
+}
+
+CatalogueService::CatalogueService(json::Dict input_info)
+        : input_info_(std::move(input_info)),
+          polyline_settings_(input_info_.at("render_settings").AsMap()),
+          stopname_settings_("stop", input_info_.at("render_settings").AsMap()),
+          busname_settings_("bus", input_info_.at("render_settings").AsMap()),
+          map_renderer_(input_info_.at("render_settings").AsMap(), polyline_settings_, stopname_settings_, busname_settings_),
+          query_server_(catalogue_, map_renderer_){
+    if(input_info_.count("base_requests")){
+        catalogue_.Update([this](TransportCatalogue& catalogue){
+            input::JSONReader(catalogue).CreateDb(input_info_);
+        });
+    }
+}
+
+CatalogueService::CatalogueService(const json::compact::Document& document)
+        : CatalogueService(ToDictWithoutBaseRequests(document.GetRoot())){
+    catalogue_.Update([&document](TransportCatalogue& catalogue){
+        input::JSONReader(catalogue).CreateDb(document.GetRoot().At("base_requests"));
+    });
+}
+
+CatalogueService::CatalogueService(std::istream& input)
+        : CatalogueService(LoadDocument(input)){}
+
+std::shared_ptr<const TransportCatalogue> CatalogueService::GetCatalogue() const{
+    return catalogue_.Current();
+}
+
+const MapRenderer& CatalogueService::GetRenderer() const{
+    return map_renderer_;
+}
+
+const server::QueryServer& CatalogueService::GetQueryServer() const{
+    return query_server_;
+}
+
+void CatalogueService::PrintResponse(std::ostream& output) const{
+    std::shared_ptr<const TransportCatalogue> snapshot = catalogue_.Current();
+    std::optional<ResponseFragments> fragments;
+    if(ResponseFragments::IsEnabled()){
+        fragments.emplace(snapshot);
+    }
+    input::JSONReader(*snapshot).PrintResponse(map_renderer_, input_info_, output, fragments ? &*fragments : nullptr);
+}
+
+}
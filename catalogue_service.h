@@ -0,0 +1,43 @@
+#pragma once
+
+#include "json.h"
+#include "json_compact.h"
+#include "json_reader.h"
+#include "map_renderer.h"
+#include "query_server.h"
+#include "transport_catalogue.h"
+#include "versioned_catalogue.h"
+
+#include <iostream>
+#include <memory>
+
+namespace transport_catalogue{
+
+class CatalogueService{
+
+public:
+
+    explicit CatalogueService(json::Dict input_info);
+    explicit CatalogueService(const json::compact::Document& document);
+    explicit CatalogueService(std::istream& input);
+
+    CatalogueService(const CatalogueService&) = delete;
+    CatalogueService& operator=(const CatalogueService&) = delete;
+
+    std::shared_ptr<const TransportCatalogue> GetCatalogue() const;
+    const MapRenderer& GetRenderer() const;
+    const server::QueryServer& GetQueryServer() const;
+
+    void PrintResponse(std::ostream& output) const;
+
+private:
+    json::Dict input_info_;
+    VersionedCatalogue catalogue_;
+    PolylineSettings polyline_settings_;
+    StopnameUnderlayerSettings stopname_settings_;
+    BusnameUnderlayerSettings busname_settings_;
+    MapRenderer map_renderer_;
+    server::QueryServer query_server_;
+};
+
+}
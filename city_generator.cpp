@@ -0,0 +1,227 @@
+#include "city_generator.h"
+#include "geo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace transport_catalogue{
+namespace bench{
+
+namespace {
+
+class ZipfDistribution{
+
+public:
+
+    ZipfDistribution(size_t n, double exponent): cdf_(n){
+        double sum = 0;
+        for(size_t rank = 0; rank < n; ++rank){
+            sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+            cdf_[rank] = sum;
+        }
+        for(double& value : cdf_){
+            value /= sum;
+        }
+    }
+
+    size_t operator()(std::mt19937_64& random) const{
+        double value = std::uniform_real_distribution<double>(0, 1)(random);
+        size_t rank = std::lower_bound(cdf_.begin(), cdf_.end(), value) - cdf_.begin();
+        return std::min(rank, cdf_.size() - 1);
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+struct Route{
+    std::vector<uint32_t> stops;
+    bool is_roundtrip;
+};
+
+struct City{
+    size_t side = 0;
+    std::vector<Coordinates> coordinates;
+    std::vector<std::vector<std::pair<uint32_t, int>>> distances;
+    std::vector<Route> routes;
+};
+
+void AddDistance(City& city, uint32_t from, uint32_t to, std::mt19937_64& random){
+    if(from == to){
+        return;
+    }
+    auto& distances = city.distances[from];
+    if(std::any_of(distances.begin(), distances.end(), [to](const auto& item){ return item.first == to; })){
+        return;
+    }
+    double geo_distance = ComputeDistance(city.coordinates[from], city.coordinates[to]);
+    double detour = std::uniform_real_distribution<double>(1.1, 1.6)(random);
+    distances.emplace_back(to, std::max(1, static_cast<int>(geo_distance * detour)));
+}
+
+uint32_t RandomNeighbour(const City& city, uint32_t stop, std::mt19937_64& random){
+    const size_t count = city.coordinates.size();
+    size_t row = stop / city.side;
+    size_t column = stop % city.side;
+    std::vector<uint32_t> neighbours;
+    if(row > 0){
+        neighbours.push_back(static_cast<uint32_t>(stop - city.side));
+    }
+    if(stop + city.side < count){
+        neighbours.push_back(static_cast<uint32_t>(stop + city.side));
+    }
+    if(column > 0){
+        neighbours.push_back(stop - 1);
+    }
+    if(column + 1 < city.side && stop + 1 < count){
+        neighbours.push_back(stop + 1);
+    }
+    if(neighbours.empty()){
+        return stop;
+    }
+    return neighbours[std::uniform_int_distribution<size_t>(0, neighbours.size() - 1)(random)];
+}
+
+City GenerateCity(const CitySettings& settings, std::mt19937_64& random){
+    City city;
+    const size_t count = std::max<size_t>(settings.stops, 1);
+    city.side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    city.coordinates.reserve(count);
+    city.distances.resize(count);
+
+    const double step = 0.4 / static_cast<double>(city.side);
+    std::uniform_real_distribution<double> jitter(-0.3 * step, 0.3 * step);
+    for(size_t i = 0; i < count; ++i){
+        city.coordinates.push_back({55.55 + static_cast<double>(i / city.side) * step + jitter(random),
+                                    37.35 + static_cast<double>(i % city.side) * step + jitter(random)});
+    }
+    for(uint32_t stop = 0; stop < count; ++stop){
+        for(size_t i = 0; i < settings.distances_per_stop; ++i){
+            AddDistance(city, stop, RandomNeighbour(city, stop, random), random);
+        }
+    }
+
+    std::uniform_int_distribution<uint32_t> any_stop(0, static_cast<uint32_t>(count - 1));
+    city.routes.resize(settings.buses);
+    for(size_t bus = 0; bus < settings.buses; ++bus){
+        Route& route = city.routes[bus];
+        route.is_roundtrip = bus % 2 == 0;
+        route.stops.push_back(any_stop(random));
+        while(route.stops.size() < std::max<size_t>(settings.stops_per_route, 2)){
+            uint32_t next = RandomNeighbour(city, route.stops.back(), random);
+            AddDistance(city, route.stops.back(), next, random);
+            route.stops.push_back(next);
+        }
+        if(route.is_roundtrip){
+            AddDistance(city, route.stops.back(), route.stops.front(), random);
+            route.stops.push_back(route.stops.front());
+        }
+    }
+    return city;
+}
+
+void WriteRenderSettings(std::ostream& output){
+    output << R"("render_settings": {"width": 1200.0, "height": 1200.0, "padding": 50.0, "line_width": 14.0, )"
+              R"("stop_radius": 5.0, "bus_label_font_size": 20, "bus_label_offset": [7.0, 15.0], )"
+              R"("stop_label_font_size": 20, "stop_label_offset": [7.0, -3.0], )"
+              R"("underlayer_color": [255, 255, 255, 0.85], "underlayer_width": 3.0, )"
+              R"("color_palette": ["green", [255, 160, 0], "red", "blue", "purple"]})";
+}
+
+// запросы пишутся как отдельные объекты; separator разделяет их внутри массива или строки JSONL
+void WriteStatRequests(const CitySettings& settings, std::mt19937_64& random, std::ostream& output, std::string_view separator){
+    const size_t stop_count = std::max<size_t>(settings.stops, 1);
+    ZipfDistribution stop_ranks(stop_count, settings.zipf_exponent);
+    ZipfDistribution bus_ranks(std::max<size_t>(settings.buses, 1), settings.zipf_exponent);
+
+    // популярные объекты разбросаны по городу, а не сосредоточены в начале списка
+    std::vector<uint32_t> stop_order(stop_count);
+    std::iota(stop_order.begin(), stop_order.end(), 0);
+    std::shuffle(stop_order.begin(), stop_order.end(), random);
+    std::vector<uint32_t> bus_order(std::max<size_t>(settings.buses, 1));
+    std::iota(bus_order.begin(), bus_order.end(), 0);
+    std::shuffle(bus_order.begin(), bus_order.end(), random);
+
+    std::uniform_real_distribution<double> share(0, 1);
+    for(size_t id = 1; id <= settings.stat_requests; ++id){
+        if(id > 1){
+            output << separator;
+        }
+        double type = share(random);
+        bool miss = share(random) < settings.miss_share;
+        output << "{\"id\": "sv << id << ", \"type\": "sv;
+        if(type < settings.map_share){
+            output << "\"Map\"}"sv;
+        }else if(type < settings.map_share + settings.bus_share && settings.buses > 0){
+            output << "\"Bus\", \"name\": \""sv;
+            if(miss){
+                output << "Ghost bus "sv << id;
+            }else{
+                output << "Bus "sv << bus_order[bus_ranks(random)];
+            }
+            output << "\"}"sv;
+        }else{
+            output << "\"Stop\", \"name\": \""sv;
+            if(miss){
+                output << "Ghost stop "sv << id;
+            }else{
+                output << "Stop "sv << stop_order[stop_ranks(random)];
+            }
+            output << "\"}"sv;
+        }
+    }
+}
+
+}
+
+void WriteCity(const CitySettings& settings, std::ostream& output){
+    std::mt19937_64 random(settings.seed);
+    City city = GenerateCity(settings, random);
+
+    output.precision(9);
+    output << "{\"base_requests\": [\n"sv;
+    for(size_t stop = 0; stop < city.coordinates.size(); ++stop){
+        output << (stop == 0 ? ""sv : ",\n"sv) << "{\"type\": \"Stop\", \"name\": \"Stop "sv << stop
+               << "\", \"latitude\": "sv << city.coordinates[stop].lat
+               << ", \"longitude\": "sv << city.coordinates[stop].lng
+               << ", \"road_distances\": {"sv;
+        bool first = true;
+        for(const auto& [to, distance] : city.distances[stop]){
+            output << (first ? ""sv : ", "sv) << "\"Stop "sv << to << "\": "sv << distance;
+            first = false;
+        }
+        output << "}}"sv;
+    }
+    for(size_t bus = 0; bus < city.routes.size(); ++bus){
+        const Route& route = city.routes[bus];
+        output << ",\n{\"type\": \"Bus\", \"name\": \"Bus "sv << bus << "\", \"stops\": ["sv;
+        for(size_t i = 0; i < route.stops.size(); ++i){
+            output << (i == 0 ? ""sv : ", "sv) << "\"Stop "sv << route.stops[i] << '"';
+        }
+        output << "], \"is_roundtrip\": "sv << (route.is_roundtrip ? "true"sv : "false"sv) << '}';
+    }
+    output << "\n],\n"sv;
+
+    WriteRenderSettings(output);
+    output << ",\n\"stat_requests\": [\n"sv;
+    WriteStatRequests(settings, random, output, ",\n"sv);
+    output << "\n]}\n"sv;
+}
+
+void WriteRequestLog(const CitySettings& settings, std::ostream& output){
+    std::mt19937_64 random(settings.seed);
+    // тот же порядок вызовов генератора, что и в WriteCity, поэтому журнал совпадает с stat_requests города
+    GenerateCity(settings, random);
+    WriteStatRequests(settings, random, output, "\n"sv);
+    output << '\n';
+}
+
+}
+}
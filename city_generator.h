@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+namespace transport_catalogue{
+namespace bench{
+
+struct CitySettings{
+    size_t stops = 1000;
+    size_t buses = 100;
+    size_t stops_per_route = 20;
+    size_t distances_per_stop = 2;
+    size_t stat_requests = 1000;
+    double zipf_exponent = 1.0;
+    double bus_share = 0.45;
+    double map_share = 0.001;
+    double miss_share = 0.01;
+    uint64_t seed = 1;
+};
+
+// остановки лежат на сетке со случайным сдвигом, маршруты идут по соседним узлам сетки,
+// объекты запросов выбираются по закону Ципфа
+void WriteCity(const CitySettings& settings, std::ostream& output);
+void WriteRequestLog(const CitySettings& settings, std::ostream& output);
+
+}
+}
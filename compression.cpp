@@ -0,0 +1,250 @@
+#include "compression.h"
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef TC_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace std::literals;
+
+namespace compression {
+
+    namespace {
+        constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+        [[noreturn]] void ThrowUnsupported(Format format) {
+            throw std::runtime_error(format == Format::ZSTD ? "zstd compression is not supported by this build"s
+                                                             : "gzip compression is not supported by this build"s);
+        }
+
+#ifdef TC_HAVE_ZLIB
+        // окно 15 + 16: zlib пишет и читает заголовок gzip
+        constexpr int GZIP_WINDOW_BITS = 15 + 16;
+
+        class GzipInputBuffer : public std::streambuf {
+        public:
+            explicit GzipInputBuffer(std::streambuf* source): source_(source), input_(BUFFER_SIZE), output_(BUFFER_SIZE) {
+                if (inflateInit2(&stream_, GZIP_WINDOW_BITS) != Z_OK) {
+                    throw std::runtime_error("Failed to initialize gzip decoder"s);
+                }
+            }
+
+            ~GzipInputBuffer() override {
+                inflateEnd(&stream_);
+            }
+
+        protected:
+            int_type underflow() override {
+                if (gptr() < egptr()) {
+                    return traits_type::to_int_type(*gptr());
+                }
+                while (true) {
+                    if (stream_.avail_in == 0) {
+                        std::streamsize count = source_->sgetn(input_.data(), static_cast<std::streamsize>(input_.size()));
+                        if (count <= 0) {
+                            if (!member_finished_) {
+                                throw std::runtime_error("Truncated gzip input"s);
+                            }
+                            return traits_type::eof();
+                        }
+                        stream_.next_in = reinterpret_cast<Bytef*>(input_.data());
+                        stream_.avail_in = static_cast<uInt>(count);
+                    }
+                    // за концом одного gzip-члена может следовать следующий
+                    if (member_finished_) {
+                        inflateReset(&stream_);
+                        member_finished_ = false;
+                    }
+
+                    stream_.next_out = reinterpret_cast<Bytef*>(output_.data());
+                    stream_.avail_out = static_cast<uInt>(output_.size());
+                    int result = inflate(&stream_, Z_NO_FLUSH);
+                    if (result == Z_STREAM_END) {
+                        member_finished_ = true;
+                    } else if (result != Z_OK && result != Z_BUF_ERROR) {
+                        throw std::runtime_error("Corrupted gzip input"s);
+                    }
+
+                    size_t produced = output_.size() - stream_.avail_out;
+                    if (produced > 0) {
+                        setg(output_.data(), output_.data(), output_.data() + produced);
+                        return traits_type::to_int_type(*gptr());
+                    }
+                }
+            }
+
+        private:
+            std::streambuf* source_;
+            z_stream stream_{};
+            std::vector<char> input_;
+            std::vector<char> output_;
+            bool member_finished_ = false;
+        };
+
+        class GzipOutputBuffer : public std::streambuf {
+        public:
+            explicit GzipOutputBuffer(std::streambuf* sink): sink_(sink), input_(BUFFER_SIZE), output_(BUFFER_SIZE) {
+                if (deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                    throw std::runtime_error("Failed to initialize gzip encoder"s);
+                }
+                setp(input_.data(), input_.data() + input_.size());
+            }
+
+            ~GzipOutputBuffer() override {
+                deflateEnd(&stream_);
+            }
+
+            void Finish() {
+                if (!finished_) {
+                    Deflate(Z_FINISH);
+                    finished_ = true;
+                    sink_->pubsync();
+                }
+            }
+
+        protected:
+            int_type overflow(int_type ch) override {
+                Deflate(Z_NO_FLUSH);
+                if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+                    *pptr() = traits_type::to_char_type(ch);
+                    pbump(1);
+                }
+                return traits_type::not_eof(ch);
+            }
+
+            // сброс на каждом flush позволяет читателю распаковывать ответы построчно
+            int sync() override {
+                if (finished_) {
+                    return 0;
+                }
+                Deflate(Z_SYNC_FLUSH);
+                return sink_->pubsync();
+            }
+
+        private:
+            void Deflate(int flush) {
+                if (finished_) {
+                    throw std::logic_error("Write to finished gzip stream"s);
+                }
+                stream_.next_in = reinterpret_cast<Bytef*>(pbase());
+                stream_.avail_in = static_cast<uInt>(pptr() - pbase());
+                int result;
+                do {
+                    stream_.next_out = reinterpret_cast<Bytef*>(output_.data());
+                    stream_.avail_out = static_cast<uInt>(output_.size());
+                    result = deflate(&stream_, flush);
+                    std::streamsize produced = static_cast<std::streamsize>(output_.size() - stream_.avail_out);
+                    if (produced > 0 && sink_->sputn(output_.data(), produced) != produced) {
+                        throw std::runtime_error("Failed to write gzip output"s);
+                    }
+                } while (stream_.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+                setp(input_.data(), input_.data() + input_.size());
+            }
+
+            std::streambuf* sink_;
+            z_stream stream_{};
+            std::vector<char> input_;
+            std::vector<char> output_;
+            bool finished_ = false;
+        };
+#endif
+    }
+
+    Format DetectFormat(int first_byte) {
+        switch (first_byte) {
+            case 0x1f:
+                return Format::GZIP;
+            case 0x28:
+                return Format::ZSTD;
+            default:
+                return Format::NONE;
+        }
+    }
+
+    bool IsSupported(Format format) {
+#ifdef TC_HAVE_ZLIB
+        return format != Format::ZSTD;
+#else
+        return format == Format::NONE;
+#endif
+    }
+
+    InputStream::InputStream(std::istream& source): std::istream(source.rdbuf()) {
+        Format format = DetectFormat(source.rdbuf()->sgetc());
+        if (!IsSupported(format)) {
+            ThrowUnsupported(format);
+        }
+#ifdef TC_HAVE_ZLIB
+        if (format == Format::GZIP) {
+            buffer_ = std::make_unique<GzipInputBuffer>(source.rdbuf());
+            rdbuf(buffer_.get());
+        }
+#endif
+    }
+
+    InputStream::~InputStream() = default;
+
+    GzipOutputStream::GzipOutputStream(std::ostream& sink): std::ostream(nullptr) {
+#ifdef TC_HAVE_ZLIB
+        buffer_ = std::make_unique<GzipOutputBuffer>(sink.rdbuf());
+        rdbuf(buffer_.get());
+#else
+        (void)sink;
+        ThrowUnsupported(Format::GZIP);
+#endif
+    }
+
+    GzipOutputStream::~GzipOutputStream() {
+        try {
+            Finish();
+        } catch (...) {
+        }
+    }
+
+    void GzipOutputStream::Finish() {
+#ifdef TC_HAVE_ZLIB
+        flush();
+        static_cast<GzipOutputBuffer*>(buffer_.get())->Finish();
+#endif
+    }
+
+    std::string GzipCompress(std::string_view data) {
+        std::ostringstream out;
+        {
+            GzipOutputStream gzip(out);
+            gzip.write(data.data(), static_cast<std::streamsize>(data.size()));
+            gzip.Finish();
+        }
+        return out.str();
+    }
+
+    std::string EncodeBase64(std::string_view data) {
+        static constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"sv;
+        std::string result;
+        result.reserve((data.size() + 2) / 3 * 4);
+        size_t i = 0;
+        for (; i + 2 < data.size(); i += 3) {
+            uint32_t chunk = static_cast<unsigned char>(data[i]) << 16 | static_cast<unsigned char>(data[i + 1]) << 8
+                             | static_cast<unsigned char>(data[i + 2]);
+            result += alphabet[chunk >> 18 & 63];
+            result += alphabet[chunk >> 12 & 63];
+            result += alphabet[chunk >> 6 & 63];
+            result += alphabet[chunk & 63];
+        }
+        if (i < data.size()) {
+            uint32_t chunk = static_cast<unsigned char>(data[i]) << 16;
+            if (i + 1 < data.size()) {
+                chunk |= static_cast<unsigned char>(data[i + 1]) << 8;
+            }
+            result += alphabet[chunk >> 18 & 63];
+            result += alphabet[chunk >> 12 & 63];
+            result += i + 1 < data.size() ? alphabet[chunk >> 6 & 63] : '=';
+            result += '=';
+        }
+        return result;
+    }
+}
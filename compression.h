@@ -0,0 +1,44 @@
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace compression {
+
+    enum class Format {
+        NONE,
+        GZIP,
+        ZSTD,
+    };
+
+    // формат определяется по первому байту: ни gzip, ни zstd не может начинать JSON
+    Format DetectFormat(int first_byte);
+    bool IsSupported(Format format);
+
+    // распаковывает источник на лету, если он сжат, иначе читает его как есть
+    class InputStream : public std::istream {
+    public:
+        explicit InputStream(std::istream& source);
+        ~InputStream() override;
+
+    private:
+        std::unique_ptr<std::streambuf> buffer_;
+    };
+
+    class GzipOutputStream : public std::ostream {
+    public:
+        explicit GzipOutputStream(std::ostream& sink);
+        ~GzipOutputStream() override;
+
+        void Finish();
+
+    private:
+        std::unique_ptr<std::streambuf> buffer_;
+    };
+
+    std::string GzipCompress(std::string_view data);
+    std::string EncodeBase64(std::string_view data);
+}
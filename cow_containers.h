@@ -0,0 +1,456 @@
+#pragma once
+
+#include "flat_hash_map.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace cow_containers {
+
+    namespace detail {
+
+        // метка владельца: часть контейнера меняется на месте, только если её создал контейнер с той же меткой.
+        // копирование выдаёт новые метки и копии, и оригиналу, поэтому после него общие части только читаются,
+        // а первая запись в часть копирует её
+        class Owner {
+        public:
+            Owner(): id_(Next()) {}
+
+            Owner(const Owner& other): id_(Next()) {
+                other.Renew();
+            }
+
+            Owner(Owner&& other) noexcept: id_(other.Get()) {
+                other.Renew();
+            }
+
+            Owner& operator=(const Owner& other) {
+                if (this != &other) {
+                    Renew();
+                    other.Renew();
+                }
+                return *this;
+            }
+
+            Owner& operator=(Owner&& other) noexcept {
+                if (this != &other) {
+                    id_.store(other.Get(), std::memory_order_relaxed);
+                    other.Renew();
+                }
+                return *this;
+            }
+
+            uint64_t Get() const {
+                return id_.load(std::memory_order_relaxed);
+            }
+
+        private:
+            static uint64_t Next() {
+                static std::atomic<uint64_t> next = 1;
+                return next.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void Renew() const {
+                id_.store(Next(), std::memory_order_relaxed);
+            }
+
+            mutable std::atomic<uint64_t> id_;
+        };
+
+        template <typename Part, typename Allocator, typename... Args>
+        std::shared_ptr<Part> MakePart(Args&&... args) {
+            using PartAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Part>;
+            return std::allocate_shared<Part>(PartAllocator(), Part{std::forward<Args>(args)...});
+        }
+    }
+
+    // хеш-таблица из SHARD_COUNT независимых частей, выбираемых старшими битами хеша. копия таблицы разделяет
+    // все части с оригиналом, а изменение копирует только ту часть, в которую попал ключ.
+    // элементы читаются через константные итераторы; изменяются через operator[], FindMutable и erase
+    template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>,
+              typename Allocator = std::allocator<std::pair<const Key, Value>>>
+    class ShardedMap {
+        using Shard = flat_hash::FlatHashMap<Key, Value, Hash, Equal, Allocator>;
+
+        struct Part {
+            uint64_t owner;
+            Shard map;
+        };
+
+        static constexpr size_t SHARD_BITS = 6;
+        static constexpr size_t SHARD_COUNT = size_t{1} << SHARD_BITS;
+        using Parts = std::array<std::shared_ptr<Part>, SHARD_COUNT>;
+
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = typename Shard::value_type;
+        using size_type = size_t;
+
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = ShardedMap::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+
+            const_iterator() = default;
+
+            reference operator*() const {
+                return *inner_;
+            }
+
+            pointer operator->() const {
+                return &*inner_;
+            }
+
+            const_iterator& operator++() {
+                ++inner_;
+                SkipEmpty();
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator result = *this;
+                ++*this;
+                return result;
+            }
+
+            friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) {
+                return lhs.shard_ == rhs.shard_ && (lhs.shard_ == SHARD_COUNT || lhs.inner_ == rhs.inner_);
+            }
+
+            friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) {
+                return !(lhs == rhs);
+            }
+
+        private:
+            friend class ShardedMap;
+
+            const_iterator(const Parts* parts, size_t shard, typename Shard::const_iterator inner)
+                    : parts_(parts), shard_(shard), inner_(inner) {}
+
+            // пустые и ещё не созданные части пропускаются
+            void SkipEmpty() {
+                while (shard_ != SHARD_COUNT) {
+                    const std::shared_ptr<Part>& part = (*parts_)[shard_];
+                    if (part && inner_ != part->map.end()) {
+                        return;
+                    }
+                    if (++shard_ != SHARD_COUNT && (*parts_)[shard_]) {
+                        inner_ = (*parts_)[shard_]->map.begin();
+                    }
+                }
+            }
+
+            const Parts* parts_ = nullptr;
+            size_t shard_ = SHARD_COUNT;
+            typename Shard::const_iterator inner_;
+        };
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        const_iterator begin() const {
+            return ShardBegin(0);
+        }
+
+        const_iterator end() const {
+            return const_iterator(&parts_, SHARD_COUNT, {});
+        }
+
+        // начало части part из parts примерно равных частей для параллельного обхода
+        const_iterator PartBegin(size_t part, size_t parts) const {
+            return ShardBegin(SHARD_COUNT * part / parts);
+        }
+
+        const_iterator find(const Key& key) const {
+            return Find(key);
+        }
+
+        template <typename K, typename H = Hash, typename = typename H::is_transparent>
+        const_iterator find(const K& key) const {
+            return Find(key);
+        }
+
+        size_t count(const Key& key) const {
+            return Find(key) != end();
+        }
+
+        template <typename K, typename H = Hash, typename = typename H::is_transparent>
+        size_t count(const K& key) const {
+            return Find(key) != end();
+        }
+
+        const Value& at(const Key& key) const {
+            return At(key);
+        }
+
+        template <typename K, typename H = Hash, typename = typename H::is_transparent>
+        const Value& at(const K& key) const {
+            return At(key);
+        }
+
+        Value& operator[](const Key& key) {
+            Shard& shard = Writable(ShardOf(key));
+            size_t before = shard.size();
+            Value& value = shard[key];
+            size_ += shard.size() - before;
+            return value;
+        }
+
+        bool emplace(Key key, Value value) {
+            Shard& shard = Writable(ShardOf(key));
+            bool inserted = shard.try_emplace(std::move(key), std::move(value)).second;
+            size_ += inserted;
+            return inserted;
+        }
+
+        // значение для изменения на месте или nullptr; отсутствующий ключ часть не копирует
+        template <typename K>
+        Value* FindMutable(const K& key) {
+            size_t shard = ShardOf(key);
+            if (!parts_[shard] || parts_[shard]->map.find(key) == parts_[shard]->map.end()) {
+                return nullptr;
+            }
+            return &Writable(shard).find(key)->second;
+        }
+
+        size_t erase(const Key& key) {
+            size_t shard = ShardOf(key);
+            if (!parts_[shard] || parts_[shard]->map.count(key) == 0) {
+                return 0;
+            }
+            Writable(shard).erase(key);
+            --size_;
+            return 1;
+        }
+
+        // копируются только части, в которых есть что удалять
+        template <typename Predicate>
+        void EraseIf(Predicate predicate) {
+            for (size_t shard = 0; shard < SHARD_COUNT; ++shard) {
+                if (!parts_[shard]) {
+                    continue;
+                }
+                const Shard& current = parts_[shard]->map;
+                bool found = false;
+                for (auto it = current.begin(); it != current.end() && !found; ++it) {
+                    found = predicate(*it);
+                }
+                if (!found) {
+                    continue;
+                }
+                Shard& map = Writable(shard);
+                for (auto it = map.begin(); it != map.end();) {
+                    if (predicate(*it)) {
+                        it = map.erase(it);
+                        --size_;
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+        }
+
+        void clear() {
+            parts_.fill(nullptr);
+            size_ = 0;
+        }
+
+        void reserve(size_t count) {
+            size_t per_shard = count / SHARD_COUNT;
+            if (per_shard == 0) {
+                return;
+            }
+            for (size_t shard = 0; shard < SHARD_COUNT; ++shard) {
+                Writable(shard).reserve(per_shard + per_shard / 4);
+            }
+        }
+
+    private:
+        template <typename K>
+        const_iterator Find(const K& key) const {
+            size_t shard = ShardOf(key);
+            const std::shared_ptr<Part>& part = parts_[shard];
+            if (!part) {
+                return end();
+            }
+            auto it = part->map.find(key);
+            return it == part->map.end() ? end() : const_iterator(&parts_, shard, it);
+        }
+
+        template <typename K>
+        const Value& At(const K& key) const {
+            auto it = Find(key);
+            if (it == end()) {
+                throw std::out_of_range("ShardedMap::at");
+            }
+            return it->second;
+        }
+
+        template <typename K>
+        size_t ShardOf(const K& key) const {
+            return static_cast<size_t>(flat_hash::MixBits(hash_(key)) >> (64 - SHARD_BITS));
+        }
+
+        const_iterator ShardBegin(size_t shard) const {
+            const_iterator result(&parts_, shard,
+                                  shard != SHARD_COUNT && parts_[shard] ? parts_[shard]->map.begin() : typename Shard::const_iterator{});
+            result.SkipEmpty();
+            return result;
+        }
+
+        Shard& Writable(size_t shard) {
+            std::shared_ptr<Part>& part = parts_[shard];
+            uint64_t owner = owner_.Get();
+            if (!part) {
+                part = detail::MakePart<Part, Allocator>(owner, Shard());
+            } else if (part->owner != owner) {
+                part = detail::MakePart<Part, Allocator>(owner, part->map);
+            }
+            return part->map;
+        }
+
+        Parts parts_;
+        size_t size_ = 0;
+        detail::Owner owner_;
+        Hash hash_;
+    };
+
+    // вектор из блоков по CHUNK_SIZE элементов: копия разделяет блоки с оригиналом,
+    // а запись копирует только свой блок
+    template <typename T, typename Allocator = std::allocator<T>>
+    class ChunkedVector {
+        using Items = std::vector<T, Allocator>;
+
+        struct Part {
+            uint64_t owner;
+            Items items;
+        };
+
+        static constexpr size_t CHUNK_BITS = 12;
+        static constexpr size_t CHUNK_SIZE = size_t{1} << CHUNK_BITS;
+        using Directory = std::vector<std::shared_ptr<Part>,
+                typename std::allocator_traits<Allocator>::template rebind_alloc<std::shared_ptr<Part>>>;
+
+    public:
+        using value_type = T;
+        using size_type = size_t;
+
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            const_iterator() = default;
+
+            reference operator*() const {
+                return (*vector_)[index_];
+            }
+
+            pointer operator->() const {
+                return &(*vector_)[index_];
+            }
+
+            const_iterator& operator++() {
+                ++index_;
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator result = *this;
+                ++index_;
+                return result;
+            }
+
+            friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) {
+                return lhs.index_ == rhs.index_;
+            }
+
+            friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) {
+                return lhs.index_ != rhs.index_;
+            }
+
+        private:
+            friend class ChunkedVector;
+
+            const_iterator(const ChunkedVector* vector, size_t index): vector_(vector), index_(index) {}
+
+            const ChunkedVector* vector_ = nullptr;
+            size_t index_ = 0;
+        };
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        const T& operator[](size_t index) const {
+            return chunks_[index >> CHUNK_BITS]->items[index & (CHUNK_SIZE - 1)];
+        }
+
+        const_iterator begin() const {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator end() const {
+            return const_iterator(this, size_);
+        }
+
+        void Set(size_t index, T value) {
+            Writable(index >> CHUNK_BITS)[index & (CHUNK_SIZE - 1)] = std::move(value);
+        }
+
+        void push_back(T value) {
+            if ((size_ & (CHUNK_SIZE - 1)) == 0) {
+                Items items;
+                items.reserve(CHUNK_SIZE);
+                chunks_.push_back(detail::MakePart<Part, Allocator>(owner_.Get(), std::move(items)));
+            }
+            Writable(chunks_.size() - 1).push_back(std::move(value));
+            ++size_;
+        }
+
+        void reserve(size_t count) {
+            chunks_.reserve((count + CHUNK_SIZE - 1) >> CHUNK_BITS);
+        }
+
+    private:
+        Items& Writable(size_t chunk) {
+            std::shared_ptr<Part>& part = chunks_[chunk];
+            uint64_t owner = owner_.Get();
+            if (part->owner != owner) {
+                Items items;
+                items.reserve(CHUNK_SIZE);
+                items.assign(part->items.begin(), part->items.end());
+                part = detail::MakePart<Part, Allocator>(owner, std::move(items));
+            }
+            return part->items;
+        }
+
+        Directory chunks_;
+        size_t size_ = 0;
+        detail::Owner owner_;
+    };
+}
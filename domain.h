@@ -8,12 +8,17 @@
 struct Stop{
     std::string stopname;
     Coordinates coordinates;
+    size_t id = 0;
+    // номер остановки в порядке добавления; id может отличаться после переупорядочивания
+    size_t input_index = 0;
 };
 
 struct Bus{
     std::string busname;
     std::vector<const Stop*> stops;
     bool is_roundtrip;
+    size_t id = 0;
+    size_t unique_stops = 0;
 
     bool operator<(const Bus& r) const{
         return std::lexicographical_compare(this->busname.begin(), this->busname.end(),
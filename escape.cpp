@@ -0,0 +1,73 @@
+#include "escape.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std::literals;
+
+namespace escape {
+
+    namespace {
+        EscapeTable MakeTable(std::string_view special_chars,
+                              std::initializer_list<std::string_view> replacements) {
+            EscapeTable table{special_chars, {}};
+            auto replacement = replacements.begin();
+            for (char ch : special_chars) {
+                table.replacements[static_cast<unsigned char>(ch)] = *replacement++;
+            }
+            return table;
+        }
+
+        bool IsSpecial(char ch, const EscapeTable& table) {
+            return !table.replacements[static_cast<unsigned char>(ch)].empty();
+        }
+    }
+
+    const EscapeTable& JsonTable() {
+        static const EscapeTable table = MakeTable("\n\r\"\\"sv, {"\\n"sv, "\\r"sv, "\\\""sv, "\\\\"sv});
+        return table;
+    }
+
+    const EscapeTable& XmlTable() {
+        static const EscapeTable table = MakeTable("\"'<>&"sv, {"&quot;"sv, "&apos;"sv, "&lt;"sv, "&gt;"sv, "&amp;"sv});
+        return table;
+    }
+
+    size_t FindSpecial(const char* begin, const char* end, const EscapeTable& table) {
+        const char* pos = begin;
+#if defined(__SSE2__)
+        // 16 байт за раз: строки без спецсимволов копируются целиком
+        __m128i specials[8];
+        const size_t special_count = std::min<size_t>(table.special_chars.size(), 8);
+        for (size_t i = 0; i < special_count; ++i) {
+            specials[i] = _mm_set1_epi8(table.special_chars[i]);
+        }
+        while (end - pos >= 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+            __m128i matches = _mm_setzero_si128();
+            for (size_t i = 0; i < special_count; ++i) {
+                matches = _mm_or_si128(matches, _mm_cmpeq_epi8(chunk, specials[i]));
+            }
+            if (int mask = _mm_movemask_epi8(matches); mask != 0) {
+                return static_cast<size_t>(pos - begin) + __builtin_ctz(static_cast<unsigned>(mask));
+            }
+            pos += 16;
+        }
+#endif
+        while (pos != end && !IsSpecial(*pos, table)) {
+            ++pos;
+        }
+        return static_cast<size_t>(pos - begin);
+    }
+
+    void EscapeJson(std::string_view str, std::ostream& out) {
+        Escape(str, JsonTable(), [&out](const char* data, size_t size) { out.write(data, size); });
+    }
+
+    void EscapeXml(std::string_view str, std::ostream& out) {
+        Escape(str, XmlTable(), [&out](const char* data, size_t size) { out.write(data, size); });
+    }
+}
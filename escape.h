@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <string_view>
+
+namespace escape {
+
+    struct EscapeTable {
+        std::string_view special_chars;
+        std::array<std::string_view, 256> replacements;
+    };
+
+    const EscapeTable& JsonTable();
+    const EscapeTable& XmlTable();
+
+    size_t FindSpecial(const char* begin, const char* end, const EscapeTable& table);
+
+    template <typename Write>
+    void Escape(std::string_view str, const EscapeTable& table, Write&& write) {
+        const char* pos = str.data();
+        const char* end = pos + str.size();
+        while (pos != end) {
+            const char* special = pos + FindSpecial(pos, end, table);
+            if (special != pos) {
+                write(pos, static_cast<size_t>(special - pos));
+            }
+            if (special == end) {
+                break;
+            }
+            std::string_view replacement = table.replacements[static_cast<unsigned char>(*special)];
+            write(replacement.data(), replacement.size());
+            pos = special + 1;
+        }
+    }
+
+    void EscapeJson(std::string_view str, std::ostream& out);
+    void EscapeXml(std::string_view str, std::ostream& out);
+}
@@ -0,0 +1,594 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace flat_hash {
+
+    namespace detail {
+
+        inline uint64_t Mum(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+            __uint128_t product = static_cast<__uint128_t>(a) * b;
+            return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+            uint64_t a_high = a >> 32, a_low = a & 0xffffffffu, b_high = b >> 32, b_low = b & 0xffffffffu;
+            uint64_t middle0 = a_high * b_low, middle1 = b_high * a_low, low = a_low * b_low;
+            uint64_t sum = low + (middle0 << 32);
+            uint64_t carry = sum < low;
+            uint64_t result_low = sum + (middle1 << 32);
+            carry += result_low < sum;
+            uint64_t result_high = a_high * b_high + (middle0 >> 32) + (middle1 >> 32) + carry;
+            return result_low ^ result_high;
+#endif
+        }
+
+        inline uint64_t Read8(const unsigned char* data) {
+            uint64_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        inline uint64_t Read4(const unsigned char* data) {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        constexpr uint64_t SECRET0 = 0xa0761d6478bd642full;
+        constexpr uint64_t SECRET1 = 0xe7037ed1a0b428dbull;
+        constexpr uint64_t GOLDEN_RATIO = 0x9e3779b97f4a7c15ull;
+
+        using Control = int8_t;
+        constexpr Control EMPTY = -128;
+        constexpr Control DELETED = -2;
+        constexpr size_t GROUP_WIDTH = 16;
+
+        inline size_t LowestBit(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_ctz(mask));
+#else
+            size_t index = 0;
+            while (!(mask & 1u)) {
+                mask >>= 1;
+                ++index;
+            }
+            return index;
+#endif
+        }
+
+        // байты управления одной группы сравниваются с искомым значением за одну инструкцию
+        class Group {
+        public:
+#ifdef __SSE2__
+            explicit Group(const Control* ctrl): ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+            uint32_t Match(Control value) const {
+                return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(value))));
+            }
+
+            uint32_t MatchEmptyOrDeleted() const {
+                return static_cast<uint32_t>(_mm_movemask_epi8(ctrl_));
+            }
+
+        private:
+            __m128i ctrl_;
+#else
+            explicit Group(const Control* ctrl): ctrl_(ctrl) {}
+
+            uint32_t Match(Control value) const {
+                uint32_t mask = 0;
+                for (size_t i = 0; i < GROUP_WIDTH; ++i) {
+                    mask |= static_cast<uint32_t>(ctrl_[i] == value) << i;
+                }
+                return mask;
+            }
+
+            uint32_t MatchEmptyOrDeleted() const {
+                uint32_t mask = 0;
+                for (size_t i = 0; i < GROUP_WIDTH; ++i) {
+                    mask |= static_cast<uint32_t>(ctrl_[i] < 0) << i;
+                }
+                return mask;
+            }
+
+        private:
+            const Control* ctrl_;
+#endif
+        public:
+            uint32_t MatchEmpty() const {
+                return Match(EMPTY);
+            }
+        };
+    }
+
+    // вариант wyhash: строки до 16 байт читаются несколькими невыровненными словами без цикла
+    inline uint64_t HashBytes(const void* data, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        uint64_t seed = detail::SECRET0;
+        uint64_t a = 0;
+        uint64_t b = 0;
+        if (size <= 16) {
+            if (size >= 4) {
+                size_t shift = (size >> 3) << 2;
+                a = (detail::Read4(bytes) << 32) | detail::Read4(bytes + shift);
+                b = (detail::Read4(bytes + size - 4) << 32) | detail::Read4(bytes + size - 4 - shift);
+            } else if (size > 0) {
+                a = (uint64_t{bytes[0]} << 16) | (uint64_t{bytes[size >> 1]} << 8) | bytes[size - 1];
+            }
+        } else {
+            size_t left = size;
+            while (left > 16) {
+                seed = detail::Mum(detail::Read8(bytes) ^ detail::SECRET1, detail::Read8(bytes + 8) ^ seed);
+                bytes += 16;
+                left -= 16;
+            }
+            a = detail::Read8(bytes + left - 16);
+            b = detail::Read8(bytes + left - 8);
+        }
+        return detail::Mum(detail::SECRET1 ^ size, detail::Mum(a ^ detail::SECRET1, b ^ seed));
+    }
+
+    // перемешивает результат хешера, поэтому подходит и тождественный std::hash для чисел и указателей
+    inline uint64_t MixBits(uint64_t value) {
+        return detail::Mum(value, detail::GOLDEN_RATIO);
+    }
+
+    // прозрачный хешер: std::string, string_view и const char* ищутся без создания временной строки
+    struct StringHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view value) const {
+            return static_cast<size_t>(HashBytes(value.data(), value.size()));
+        }
+    };
+
+    // открытая адресация в духе SwissTable: слоты лежат в одном массиве, а по байтам управления
+    // (7 бит хеша или признак пустого/удалённого слота) группа из 16 слотов проверяется разом.
+    // при перестройке ключи копируются, поэтому таблица рассчитана на дешёвые ключи;
+    // ссылки на элементы, как и у std::vector, не переживают вставку
+    template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>,
+              typename Allocator = std::allocator<std::pair<const Key, Value>>>
+    class FlatHashMap {
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = std::pair<const Key, Value>;
+        using size_type = size_t;
+
+        template <bool Const>
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = FlatHashMap::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+            using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+            Iterator() = default;
+
+            template <bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+            Iterator(const Iterator<OtherConst>& other): ctrl_(other.ctrl_), slot_(other.slot_), end_(other.end_) {}
+
+            reference operator*() const {
+                return *slot_;
+            }
+
+            pointer operator->() const {
+                return slot_;
+            }
+
+            Iterator& operator++() {
+                ++ctrl_;
+                ++slot_;
+                SkipFree();
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                Iterator result = *this;
+                ++*this;
+                return result;
+            }
+
+            friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+                return lhs.ctrl_ == rhs.ctrl_;
+            }
+
+            friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+                return lhs.ctrl_ != rhs.ctrl_;
+            }
+
+        private:
+            friend class FlatHashMap;
+            friend class Iterator<!Const>;
+
+            Iterator(const detail::Control* ctrl, pointer slot, const detail::Control* end): ctrl_(ctrl), slot_(slot), end_(end) {}
+
+            void SkipFree() {
+                while (ctrl_ != end_ && *ctrl_ < 0) {
+                    ++ctrl_;
+                    ++slot_;
+                }
+            }
+
+            const detail::Control* ctrl_ = nullptr;
+            pointer slot_ = nullptr;
+            const detail::Control* end_ = nullptr;
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        FlatHashMap() = default;
+
+        // байты управления копируются вместе с отметками удалённых слотов, иначе оборвались бы цепочки проб
+        FlatHashMap(const FlatHashMap& other): hash_(other.hash_), equal_(other.equal_) {
+            if (other.size_ == 0) {
+                return;
+            }
+            Allocate(other.capacity_);
+            size_t index = 0;
+            try {
+                for (; index < capacity_; ++index) {
+                    if (other.ctrl_[index] >= 0) {
+                        new (slots_ + index) value_type(other.slots_[index]);
+                    }
+                }
+            } catch (...) {
+                for (size_t i = 0; i < index; ++i) {
+                    if (other.ctrl_[i] >= 0) {
+                        slots_[i].~value_type();
+                    }
+                }
+                Deallocate();
+                throw;
+            }
+            std::memcpy(ctrl_, other.ctrl_, capacity_);
+            size_ = other.size_;
+            growth_left_ = other.growth_left_;
+        }
+
+        FlatHashMap(FlatHashMap&& other) noexcept {
+            Swap(other);
+        }
+
+        FlatHashMap& operator=(FlatHashMap other) noexcept {
+            Swap(other);
+            return *this;
+        }
+
+        ~FlatHashMap() {
+            DestroySlots();
+            Deallocate();
+        }
+
+        iterator begin() {
+            iterator result(ctrl_, slots_, ctrl_ + capacity_);
+            result.SkipFree();
+            return result;
+        }
+
+        iterator end() {
+            return iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);
+        }
+
+        const_iterator begin() const {
+            const_iterator result(ctrl_, slots_, ctrl_ + capacity_);
+            result.SkipFree();
+            return result;
+        }
+
+        const_iterator end() const {
+            return const_iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);
+        }
+
+        // начало части part из parts, на которые поровну делятся слоты; часть кончается там, где начинается
+        // следующая, а PartBegin(parts, parts) == end(). так таблицу можно обойти из нескольких потоков
+        const_iterator PartBegin(size_t part, size_t parts) const {
+            const_iterator result = IteratorAt(capacity_ * part / parts);
+            result.SkipFree();
+            return result;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        iterator find(const Key& key) {
+            return IteratorAt(FindIndex(key));
+        }
+
+        const_iterator find(const Key& key) const {
+            return IteratorAt(FindIndex(key));
+        }
+
+        template <typename K, typename H = Hash, typename = typename H::is_transparent>
+        iterator find(const K& key) {
+            return IteratorAt(FindIndex(key));
+        }
+
+        template <typename K, typename H = Hash, typename = typename H::is_transparent>
+        const_iterator find(const K& key) const {
+            return IteratorAt(FindIndex(key));
+        }
+
+        size_t count(const Key& key) const {
+            return FindIndex(key) != capacity_;
+        }
+
+        template <typename K, typename H = Hash, typename = typename H::is_transparent>
+        size_t count(const K& key) const {
+            return FindIndex(key) != capacity_;
+        }
+
+        Value& at(const Key& key) {
+            return AtIndex(FindIndex(key));
+        }
+
+        const Value& at(const Key& key) const {
+            return AtIndex(FindIndex(key));
+        }
+
+        template <typename K, typename H = Hash, typename = typename H::is_transparent>
+        Value& at(const K& key) {
+            return AtIndex(FindIndex(key));
+        }
+
+        template <typename K, typename H = Hash, typename = typename H::is_transparent>
+        const Value& at(const K& key) const {
+            return AtIndex(FindIndex(key));
+        }
+
+        Value& operator[](const Key& key) {
+            return try_emplace(key).first->second;
+        }
+
+        template <typename K, typename... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+            size_t index = FindIndex(key);
+            if (index != capacity_) {
+                return {IteratorAt(index), false};
+            }
+            uint64_t hash = MixBits(hash_(key));
+            if (capacity_ == 0) {
+                Rehash(detail::GROUP_WIDTH);
+            }
+            index = FindInsertSlot(hash);
+            if (growth_left_ == 0 && ctrl_[index] == detail::EMPTY) {
+                Rehash(NextCapacity());
+                index = FindInsertSlot(hash);
+            }
+            new (slots_ + index) value_type(std::piecewise_construct,
+                                            std::forward_as_tuple(std::forward<K>(key)),
+                                            std::forward_as_tuple(std::forward<Args>(args)...));
+            if (ctrl_[index] == detail::EMPTY) {
+                --growth_left_;
+            }
+            ctrl_[index] = static_cast<detail::Control>(hash & 0x7f);
+            ++size_;
+            return {IteratorAt(index), true};
+        }
+
+        std::pair<iterator, bool> emplace(Key key, Value value) {
+            return try_emplace(std::move(key), std::move(value));
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value) {
+            return try_emplace(value.first, value.second);
+        }
+
+        iterator erase(iterator position) {
+            size_t index = static_cast<size_t>(position.slot_ - slots_);
+            EraseAt(index);
+            iterator next(ctrl_ + index + 1, slots_ + index + 1, ctrl_ + capacity_);
+            next.SkipFree();
+            return next;
+        }
+
+        size_t erase(const Key& key) {
+            size_t index = FindIndex(key);
+            if (index == capacity_) {
+                return 0;
+            }
+            EraseAt(index);
+            return 1;
+        }
+
+        void clear() {
+            DestroySlots();
+            if (capacity_ != 0) {
+                std::memset(ctrl_, static_cast<unsigned char>(detail::EMPTY), capacity_);
+            }
+            size_ = 0;
+            growth_left_ = MaxLoad(capacity_);
+        }
+
+        void reserve(size_t count) {
+            if (count <= MaxLoad(capacity_)) {
+                return;
+            }
+            size_t capacity = detail::GROUP_WIDTH;
+            while (MaxLoad(capacity) < count) {
+                capacity *= 2;
+            }
+            Rehash(capacity);
+        }
+
+    private:
+        using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+        using ControlAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<detail::Control>;
+
+        static size_t MaxLoad(size_t capacity) {
+            return capacity - capacity / 8;
+        }
+
+        // группы перебираются с треугольным шагом: при числе групп, равном степени двойки, обходятся все
+        template <typename K>
+        size_t FindIndex(const K& key) const {
+            if (capacity_ == 0) {
+                return capacity_;
+            }
+            uint64_t hash = MixBits(hash_(key));
+            auto h2 = static_cast<detail::Control>(hash & 0x7f);
+            size_t group_mask = capacity_ / detail::GROUP_WIDTH - 1;
+            size_t group = (hash >> 7) & group_mask;
+            for (size_t step = 1;; ++step) {
+                detail::Group candidates(ctrl_ + group * detail::GROUP_WIDTH);
+                for (uint32_t match = candidates.Match(h2); match != 0; match &= match - 1) {
+                    size_t index = group * detail::GROUP_WIDTH + detail::LowestBit(match);
+                    if (equal_(slots_[index].first, key)) {
+                        return index;
+                    }
+                }
+                if (candidates.MatchEmpty() != 0) {
+                    return capacity_;
+                }
+                group = (group + step) & group_mask;
+            }
+        }
+
+        size_t FindInsertSlot(uint64_t hash) const {
+            size_t group_mask = capacity_ / detail::GROUP_WIDTH - 1;
+            size_t group = (hash >> 7) & group_mask;
+            for (size_t step = 1;; ++step) {
+                uint32_t free = detail::Group(ctrl_ + group * detail::GROUP_WIDTH).MatchEmptyOrDeleted();
+                if (free != 0) {
+                    return group * detail::GROUP_WIDTH + detail::LowestBit(free);
+                }
+                group = (group + step) & group_mask;
+            }
+        }
+
+        // пустой слот можно вернуть, только если в его группе уже есть пустой: тогда ни одна цепочка проб через неё не проходит
+        void EraseAt(size_t index) {
+            slots_[index].~value_type();
+            --size_;
+            size_t group_start = index & ~(detail::GROUP_WIDTH - 1);
+            if (detail::Group(ctrl_ + group_start).MatchEmpty() != 0) {
+                ctrl_[index] = detail::EMPTY;
+                ++growth_left_;
+            } else {
+                ctrl_[index] = detail::DELETED;
+            }
+        }
+
+        // если место занято в основном удалёнными слотами, таблица перестраивается без роста
+        size_t NextCapacity() const {
+            return size_ + 1 > MaxLoad(capacity_) / 2 ? capacity_ * 2 : capacity_;
+        }
+
+        void Rehash(size_t capacity) {
+            detail::Control* old_ctrl = ctrl_;
+            value_type* old_slots = slots_;
+            size_t old_capacity = capacity_;
+            Allocate(capacity);
+            for (size_t i = 0; i < old_capacity; ++i) {
+                if (old_ctrl[i] < 0) {
+                    continue;
+                }
+                uint64_t hash = MixBits(hash_(old_slots[i].first));
+                size_t index = FindInsertSlot(hash);
+                new (slots_ + index) value_type(old_slots[i].first, std::move(old_slots[i].second));
+                ctrl_[index] = static_cast<detail::Control>(hash & 0x7f);
+                --growth_left_;
+                old_slots[i].~value_type();
+            }
+            Deallocate(old_ctrl, old_slots, old_capacity);
+        }
+
+        void Allocate(size_t capacity) {
+            ctrl_ = ControlAllocator().allocate(capacity);
+            try {
+                slots_ = SlotAllocator().allocate(capacity);
+            } catch (...) {
+                ControlAllocator().deallocate(ctrl_, capacity);
+                throw;
+            }
+            std::memset(ctrl_, static_cast<unsigned char>(detail::EMPTY), capacity);
+            capacity_ = capacity;
+            growth_left_ = MaxLoad(capacity);
+        }
+
+        void Deallocate() {
+            Deallocate(ctrl_, slots_, capacity_);
+            ctrl_ = nullptr;
+            slots_ = nullptr;
+            capacity_ = 0;
+            growth_left_ = 0;
+        }
+
+        static void Deallocate(detail::Control* ctrl, value_type* slots, size_t capacity) {
+            if (capacity != 0) {
+                ControlAllocator().deallocate(ctrl, capacity);
+                SlotAllocator().deallocate(slots, capacity);
+            }
+        }
+
+        void DestroySlots() {
+            for (size_t i = 0; i < capacity_; ++i) {
+                if (ctrl_[i] >= 0) {
+                    slots_[i].~value_type();
+                }
+            }
+        }
+
+        void Swap(FlatHashMap& other) noexcept {
+            std::swap(ctrl_, other.ctrl_);
+            std::swap(slots_, other.slots_);
+            std::swap(capacity_, other.capacity_);
+            std::swap(size_, other.size_);
+            std::swap(growth_left_, other.growth_left_);
+            std::swap(hash_, other.hash_);
+            std::swap(equal_, other.equal_);
+        }
+
+        iterator IteratorAt(size_t index) {
+            return iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+        }
+
+        const_iterator IteratorAt(size_t index) const {
+            return const_iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+        }
+
+        Value& AtIndex(size_t index) {
+            if (index == capacity_) {
+                throw std::out_of_range("FlatHashMap::at");
+            }
+            return slots_[index].second;
+        }
+
+        const Value& AtIndex(size_t index) const {
+            if (index == capacity_) {
+                throw std::out_of_range("FlatHashMap::at");
+            }
+            return slots_[index].second;
+        }
+
+        detail::Control* ctrl_ = nullptr;
+        value_type* slots_ = nullptr;
+        size_t capacity_ = 0;
+        size_t size_ = 0;
+        size_t growth_left_ = 0;
+        Hash hash_;
+        Equal equal_;
+    };
+}
@@ -0,0 +1,159 @@
+// с TC_TEST_PORTABLE_GROUP группа проверяется побайтовым циклом вместо SSE2
+#ifdef TC_TEST_PORTABLE_GROUP
+#undef __SSE2__
+#endif
+
+#include "flat_hash_map.h"
+#include "test_check.h"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// все ключи попадают в несколько групп и имеют одинаковые 7 бит: цепочки проб длинные, а Match даёт много ложных совпадений
+struct CollidingHash {
+    size_t operator()(int key) const {
+        return static_cast<size_t>(key % 3);
+    }
+};
+
+template <typename Map>
+void CheckSame(const Map& map, const std::unordered_map<int, int>& reference) {
+    TC_CHECK(map.size() == reference.size());
+    size_t visited = 0;
+    for (const auto& [key, value] : map) {
+        auto it = reference.find(key);
+        TC_CHECK(it != reference.end() && it->second == value);
+        ++visited;
+    }
+    TC_CHECK(visited == reference.size());
+    for (const auto& [key, value] : reference) {
+        auto it = map.find(key);
+        TC_CHECK(it != map.end() && it->second == value);
+    }
+}
+
+void TestInsertEraseReinsertAcrossRehash() {
+    flat_hash::FlatHashMap<int, int> map;
+    std::unordered_map<int, int> reference;
+    for (int key = 0; key < 10000; ++key) {
+        TC_CHECK(map.try_emplace(key, key * 2).second);
+        reference[key] = key * 2;
+    }
+    TC_CHECK(!map.try_emplace(5, 0).second);
+    CheckSame(map, reference);
+
+    for (int key = 0; key < 10000; key += 2) {
+        TC_CHECK(map.erase(key) == 1);
+        reference.erase(key);
+    }
+    TC_CHECK(map.erase(0) == 0);
+    TC_CHECK(map.find(0) == map.end());
+    CheckSame(map, reference);
+
+    // повторная вставка попадает в удалённые слоты, а новые ключи заставляют таблицу расти
+    for (int key = 0; key < 20000; key += 2) {
+        map[key] = -key;
+        reference[key] = -key;
+    }
+    CheckSame(map, reference);
+}
+
+// вставки и удаления при постоянном размере копят удалённые слоты, пока таблица не перестроится без роста
+void TestTombstoneChurn() {
+    flat_hash::FlatHashMap<int, int, CollidingHash> map;
+    std::unordered_map<int, int> reference;
+    std::mt19937 random(42);
+    for (int step = 0; step < 200000; ++step) {
+        int key = static_cast<int>(random() % 300);
+        if (random() % 2 == 0) {
+            map[key] = step;
+            reference[key] = step;
+        } else {
+            TC_CHECK(map.erase(key) == reference.erase(key));
+        }
+    }
+    CheckSame(map, reference);
+}
+
+void TestEraseWhileIterating() {
+    flat_hash::FlatHashMap<int, int> map;
+    std::unordered_map<int, int> reference;
+    for (int key = 0; key < 5000; ++key) {
+        map[key] = key;
+        if (key % 3 != 0) {
+            reference[key] = key;
+        }
+    }
+    for (auto it = map.begin(); it != map.end();) {
+        it = it->first % 3 == 0 ? map.erase(it) : std::next(it);
+    }
+    CheckSame(map, reference);
+}
+
+// копия сохраняет отметки удалённых слотов, иначе ключи за ними стали бы недоступны
+void TestCopyAndMoveKeepProbeChains() {
+    flat_hash::FlatHashMap<int, int, CollidingHash> map;
+    std::unordered_map<int, int> reference;
+    for (int key = 0; key < 1000; ++key) {
+        map[key] = key;
+        reference[key] = key;
+    }
+    for (int key = 0; key < 1000; key += 5) {
+        map.erase(key);
+        reference.erase(key);
+    }
+    flat_hash::FlatHashMap<int, int, CollidingHash> copy(map);
+    CheckSame(copy, reference);
+    flat_hash::FlatHashMap<int, int, CollidingHash> moved(std::move(copy));
+    CheckSame(moved, reference);
+    moved.clear();
+    TC_CHECK(moved.empty() && moved.begin() == moved.end());
+    map = moved;
+    TC_CHECK(map.empty() && map.find(1) == map.end());
+}
+
+void TestTransparentStringLookup() {
+    flat_hash::FlatHashMap<std::string, int, flat_hash::StringHash, std::equal_to<>> map;
+    std::vector<std::string> names;
+    for (int i = 0; i < 2000; ++i) {
+        names.push_back("Stop " + std::string(static_cast<size_t>(i % 40), 'x') + std::to_string(i));
+        map[names.back()] = i;
+    }
+    for (int i = 0; i < 2000; ++i) {
+        std::string_view name = names[static_cast<size_t>(i)];
+        TC_CHECK(map.count(name) == 1 && map.at(name) == i);
+    }
+    TC_CHECK(map.find(std::string_view("Stop")) == map.end());
+}
+
+void TestPartsCoverAllElements() {
+    flat_hash::FlatHashMap<int, int> map;
+    for (int key = 0; key < 3000; ++key) {
+        map[key] = key;
+    }
+    for (size_t parts : {1, 3, 7, 64}) {
+        size_t visited = 0;
+        for (size_t part = 0; part < parts; ++part) {
+            for (auto it = map.PartBegin(part, parts); it != map.PartBegin(part + 1, parts); ++it) {
+                ++visited;
+            }
+        }
+        TC_CHECK(visited == map.size());
+    }
+}
+
+}
+
+int main() {
+    TestInsertEraseReinsertAcrossRehash();
+    TestTombstoneChurn();
+    TestEraseWhileIterating();
+    TestCopyAndMoveKeepProbeChains();
+    TestTransparentStringLookup();
+    TestPartsCoverAllElements();
+    std::cout << "flat_hash_map_test: OK" << std::endl;
+}
@@ -6,4 +6,57 @@ bool Coordinates::operator==(const Coordinates& other) const {
 
 bool Coordinates::operator!=(const Coordinates& other) const {
     return !(*this == other);
+}
+
+namespace {
+
+constexpr int GRID_BITS = 16;
+constexpr uint32_t GRID_SIZE = 1u << GRID_BITS;
+
+uint32_t Quantize(double value, double min, double max) {
+    if (!(max > min)) {
+        return 0;
+    }
+    double cell = (value - min) / (max - min) * GRID_SIZE;
+    return cell >= GRID_SIZE - 1 ? GRID_SIZE - 1 : cell <= 0 ? 0 : static_cast<uint32_t>(cell);
+}
+
+uint64_t SpreadBits(uint32_t value) {
+    uint64_t result = value;
+    result = (result | (result << 8)) & 0x00ff00ffull;
+    result = (result | (result << 4)) & 0x0f0f0f0full;
+    result = (result | (result << 2)) & 0x33333333ull;
+    result = (result | (result << 1)) & 0x55555555ull;
+    return result;
+}
+
+}
+
+uint64_t MortonKey(Coordinates point, Coordinates min, Coordinates max) {
+    uint32_t x = Quantize(point.lng, min.lng, max.lng);
+    uint32_t y = Quantize(point.lat, min.lat, max.lat);
+    return (SpreadBits(y) << 1) | SpreadBits(x);
+}
+
+// на каждом уровне берётся квадрант точки, а сама точка поворачивается так, чтобы внутри квадранта
+// кривая шла в том же порядке, что и на уровень выше
+uint64_t HilbertKey(Coordinates point, Coordinates min, Coordinates max) {
+    uint32_t x = Quantize(point.lng, min.lng, max.lng);
+    uint32_t y = Quantize(point.lat, min.lat, max.lat);
+    uint64_t key = 0;
+    for (uint32_t half = GRID_SIZE / 2; half > 0; half /= 2) {
+        uint32_t right = (x & half) ? 1 : 0;
+        uint32_t top = (y & half) ? 1 : 0;
+        key += static_cast<uint64_t>(half) * half * ((3 * right) ^ top);
+        if (top == 0) {
+            if (right == 1) {
+                x = GRID_SIZE - 1 - x;
+                y = GRID_SIZE - 1 - y;
+            }
+            uint32_t swap = x;
+            x = y;
+            y = swap;
+        }
+    }
+    return key;
 }
\ No newline at end of file
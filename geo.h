@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 
 const int EARTH_RADIUS = 6371000;
 
@@ -20,4 +21,10 @@ inline double ComputeDistance(Coordinates from, Coordinates to) {
     return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
         * EARTH_RADIUS;
-}
\ No newline at end of file
+}
+
+// положение точки на кривой, заполняющей прямоугольник [min, max], в сетке 2^16 x 2^16 клеток:
+// точки с близкими ключами близки и на плоскости. у кривой Гильберта соседние ключи - всегда соседние клетки,
+// у Мортона (Z-порядок) бывают скачки, зато ключ считается простым чередованием битов
+uint64_t MortonKey(Coordinates point, Coordinates min, Coordinates max);
+uint64_t HilbertKey(Coordinates point, Coordinates min, Coordinates max);
\ No newline at end of file
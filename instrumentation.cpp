@@ -0,0 +1,145 @@
+#include "instrumentation.h"
+
+#include <array>
+
+using namespace std::literals;
+
+namespace instrumentation {
+
+    namespace detail {
+        std::atomic<bool> enabled = false;
+    }
+
+    namespace {
+        constexpr size_t METRIC_COUNT = static_cast<size_t>(Metric::COUNT);
+
+        constexpr std::array<std::string_view, METRIC_COUNT> METRIC_NAMES{
+                "parse"sv,
+                "create_db_decode"sv,
+                "create_db_stops"sv,
+                "create_db_reorder"sv,
+                "create_db_distances"sv,
+                "create_db_buses"sv,
+                "create_db_components"sv,
+                "create_db_freeze"sv,
+                "route_length"sv,
+                "query_bus"sv,
+                "query_stop"sv,
+                "query_map"sv,
+                "query_stats"sv,
+                "query_memory"sv,
+                "query_autocomplete"sv,
+                "query_fuzzy_search"sv,
+                "query_analytics"sv,
+                "query_fragment"sv,
+                "projection"sv,
+                "svg_render"sv,
+                "route_segments"sv,
+                "svg_objects"sv,
+                "batch_queries"sv,
+                "batch_unique_queries"sv,
+        };
+
+        // ячейки разнесены по строкам кэша, чтобы параллельные запросы разных типов не мешали друг другу
+        struct alignas(64) MetricCell {
+            std::atomic<uint64_t> count = 0;
+            std::atomic<uint64_t> total_ns = 0;
+            std::atomic<uint64_t> max_ns = 0;
+        };
+
+        std::array<MetricCell, METRIC_COUNT> cells;
+
+        bool IsTimer(size_t index) {
+            return index < static_cast<size_t>(Metric::ROUTE_SEGMENTS);
+        }
+    }
+
+    bool IsCompiledIn() {
+#ifdef TC_ENABLE_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void SetEnabled(bool enabled) {
+        detail::enabled.store(enabled && IsCompiledIn(), std::memory_order_relaxed);
+    }
+
+    void Reset() {
+        for (MetricCell& cell : cells) {
+            cell.count.store(0, std::memory_order_relaxed);
+            cell.total_ns.store(0, std::memory_order_relaxed);
+            cell.max_ns.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void RecordTime(Metric metric, uint64_t ns) {
+        MetricCell& cell = cells[static_cast<size_t>(metric)];
+        cell.count.fetch_add(1, std::memory_order_relaxed);
+        cell.total_ns.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t max = cell.max_ns.load(std::memory_order_relaxed);
+        while (ns > max && !cell.max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    void RecordCount(Metric metric, uint64_t count) {
+        cells[static_cast<size_t>(metric)].count.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    std::vector<MetricSnapshot> Snapshot() {
+        std::vector<MetricSnapshot> result;
+        result.reserve(METRIC_COUNT);
+        for (size_t i = 0; i < METRIC_COUNT; ++i) {
+            result.push_back({METRIC_NAMES[i], IsTimer(i),
+                              cells[i].count.load(std::memory_order_relaxed),
+                              cells[i].total_ns.load(std::memory_order_relaxed),
+                              cells[i].max_ns.load(std::memory_order_relaxed)});
+        }
+        return result;
+    }
+
+    void WritePrometheus(std::ostream& out) {
+        std::vector<MetricSnapshot> snapshot = Snapshot();
+        out << "# TYPE tc_phase_calls_total counter\n"sv;
+        for (const MetricSnapshot& metric : snapshot) {
+            if (metric.is_timer) {
+                out << "tc_phase_calls_total{phase=\""sv << metric.name << "\"} "sv << metric.count << '\n';
+            }
+        }
+        out << "# TYPE tc_phase_seconds_total counter\n"sv;
+        for (const MetricSnapshot& metric : snapshot) {
+            if (metric.is_timer) {
+                out << "tc_phase_seconds_total{phase=\""sv << metric.name << "\"} "sv << metric.total_ns / 1e9 << '\n';
+            }
+        }
+        out << "# TYPE tc_phase_max_seconds gauge\n"sv;
+        for (const MetricSnapshot& metric : snapshot) {
+            if (metric.is_timer) {
+                out << "tc_phase_max_seconds{phase=\""sv << metric.name << "\"} "sv << metric.max_ns / 1e9 << '\n';
+            }
+        }
+        out << "# TYPE tc_events_total counter\n"sv;
+        for (const MetricSnapshot& metric : snapshot) {
+            if (!metric.is_timer) {
+                out << "tc_events_total{event=\""sv << metric.name << "\"} "sv << metric.count << '\n';
+            }
+        }
+        out.flush();
+    }
+
+    void WriteJson(std::ostream& out) {
+        out << '{';
+        bool first = true;
+        for (const MetricSnapshot& metric : Snapshot()) {
+            out << (first ? ""sv : ", "sv) << '"' << metric.name << "\": {\"count\": "sv << metric.count;
+            if (metric.is_timer) {
+                out << ", \"total_us\": "sv << metric.total_ns / 1000 << ", \"max_us\": "sv << metric.max_ns / 1000;
+            }
+            out << '}';
+            first = false;
+        }
+        out << "}\n"sv;
+        out.flush();
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace instrumentation {
+
+    enum class Metric : uint8_t {
+        PARSE,
+        CREATE_DB_DECODE,
+        CREATE_DB_STOPS,
+        CREATE_DB_REORDER,
+        CREATE_DB_DISTANCES,
+        CREATE_DB_BUSES,
+        CREATE_DB_COMPONENTS,
+        CREATE_DB_FREEZE,
+        ROUTE_LENGTH,
+        QUERY_BUS,
+        QUERY_STOP,
+        QUERY_MAP,
+        QUERY_STATS,
+        QUERY_MEMORY,
+        QUERY_AUTOCOMPLETE,
+        QUERY_FUZZY_SEARCH,
+        QUERY_ANALYTICS,
+        QUERY_FRAGMENT,
+        PROJECTION,
+        SVG_RENDER,
+        // ниже счётчики событий, а не таймеры
+        ROUTE_SEGMENTS,
+        SVG_OBJECTS,
+        BATCH_QUERIES,
+        BATCH_UNIQUE_QUERIES,
+        COUNT,
+    };
+
+    struct MetricSnapshot {
+        std::string_view name;
+        bool is_timer = true;
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+    };
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+    }
+
+    // сбор можно выключить во время работы; выключенный таймер стоит одной загрузки флага
+    inline bool IsEnabled() {
+#ifdef TC_ENABLE_STATS
+        return detail::enabled.load(std::memory_order_relaxed);
+#else
+        return false;
+#endif
+    }
+
+    bool IsCompiledIn();
+    void SetEnabled(bool enabled);
+    void Reset();
+
+    void RecordTime(Metric metric, uint64_t ns);
+    void RecordCount(Metric metric, uint64_t count);
+
+    std::vector<MetricSnapshot> Snapshot();
+    void WritePrometheus(std::ostream& out);
+    void WriteJson(std::ostream& out);
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Metric metric): metric_(metric), enabled_(IsEnabled()) {
+            if (enabled_) {
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~ScopedTimer() {
+            if (enabled_) {
+                auto elapsed = std::chrono::steady_clock::now() - start_;
+                RecordTime(metric_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Metric metric_;
+        bool enabled_;
+        std::chrono::steady_clock::time_point start_;
+    };
+}
+
+#define TC_STATS_CONCAT_IMPL(a, b) a##b
+#define TC_STATS_CONCAT(a, b) TC_STATS_CONCAT_IMPL(a, b)
+
+#ifdef TC_ENABLE_STATS
+#define TC_SCOPED_TIMER(metric) \
+    ::instrumentation::ScopedTimer TC_STATS_CONCAT(tc_scoped_timer_, __LINE__)(::instrumentation::Metric::metric)
+#define TC_COUNT(metric, value) \
+    do { \
+        if (::instrumentation::IsEnabled()) { \
+            ::instrumentation::RecordCount(::instrumentation::Metric::metric, (value)); \
+        } \
+    } while (false)
+#else
+#define TC_SCOPED_TIMER(metric) ((void)0)
+#define TC_COUNT(metric, value) ((void)0)
+#endif
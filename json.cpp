@@ -1,4 +1,8 @@
 #include "json.h"
+#include "escape.h"
+
+#include <cctype>
+#include <charconv>
 
 using namespace std;
 
@@ -130,63 +134,89 @@ namespace json {
         }
     }
 
-    Node LoadNumber(std::istream& input) {
-        using namespace std::literals;
-
-        input.unget();
-        std::string parsed_num;
-
-        auto read_char = [&parsed_num, &input] {
-            parsed_num += static_cast<char>(input.get());
-            if (!input) {
-                throw ParsingError("Failed to read number from stream"s);
-            }
-        };
-
-        auto read_digits = [&input, read_char] {
-            if (!std::isdigit(input.peek())) {
-                throw ParsingError("A digit is expected"s);
+    NumberParseResult ParseNumber(const char* begin, const char* end) {
+        NumberParseResult result;
+        const char* pos = begin;
+        auto read_digits = [&pos, end] {
+            if (pos == end || !std::isdigit(static_cast<unsigned char>(*pos))) {
+                return false;
             }
-            while (std::isdigit(input.peek())) {
-                read_char();
+            while (pos != end && std::isdigit(static_cast<unsigned char>(*pos))) {
+                ++pos;
             }
+            return true;
         };
 
-        if (input.peek() == '-') {
-            read_char();
+        if (pos != end && *pos == '-') {
+            ++pos;
         }
-        if (input.peek() == '0') {
-            read_char();
-        } else {
-            read_digits();
+        if (pos != end && *pos == '0') {
+            ++pos;
+        } else if (!read_digits()) {
+            return result;
         }
 
         bool is_int = true;
-        if (input.peek() == '.') {
-            read_char();
-            read_digits();
+        if (pos != end && *pos == '.') {
+            ++pos;
+            if (!read_digits()) {
+                return result;
+            }
             is_int = false;
         }
-
-        if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-            read_char();
-            if (ch = input.peek(); ch == '+' || ch == '-') {
-                read_char();
+        if (pos != end && (*pos == 'e' || *pos == 'E')) {
+            ++pos;
+            if (pos != end && (*pos == '+' || *pos == '-')) {
+                ++pos;
+            }
+            if (!read_digits()) {
+                return result;
             }
-            read_digits();
             is_int = false;
         }
 
-        try {
-            if (is_int) {
-                try {
-                    return Node(std::stoi(parsed_num));
-                } catch (...) {}
+        // целое, не помещающееся в int, разбирается как double
+        if (is_int) {
+            if (auto [ptr, ec] = std::from_chars(begin, pos, result.int_value); ec == std::errc()) {
+                result.ptr = ptr;
+                result.is_int = true;
+                return result;
             }
-            return Node(std::stod(parsed_num));
-        } catch (...) {
-            throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
         }
+        if (auto [ptr, ec] = std::from_chars(begin, pos, result.double_value); ec == std::errc()) {
+            result.ptr = ptr;
+        }
+        return result;
+    }
+
+    Node LoadNumber(std::istream& input) {
+        using namespace std::literals;
+
+        input.unget();
+        auto is_number_char = [](int ch) {
+            return std::isdigit(ch) || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E';
+        };
+
+        char buffer[64];
+        size_t size = 0;
+        std::string long_number;
+        std::streambuf* buf = input.rdbuf();
+        for (int ch = buf->sgetc(); ch != EOF && is_number_char(ch); ch = buf->snextc()) {
+            if (size == sizeof(buffer)) {
+                long_number.append(buffer, size);
+                size = 0;
+            }
+            buffer[size++] = static_cast<char>(ch);
+        }
+        long_number.append(buffer, size);
+
+        const char* begin = long_number.data();
+        const char* end = begin + long_number.size();
+        NumberParseResult result = ParseNumber(begin, end);
+        if (result.ptr != end || begin == end) {
+            throw ParsingError("Failed to convert "s + long_number + " to number"s);
+        }
+        return result.is_int ? Node(result.int_value) : Node(result.double_value);
     }
 
     Node LoadNode(istream& input) {
@@ -311,6 +341,29 @@ namespace json {
         return Document{LoadNode(input)};
     }
 
+    namespace {
+        bool shortest_doubles = false;
+    }
+
+    void SetShortestDoubles(bool enabled) {
+        shortest_doubles = enabled;
+    }
+
+    void PrintValue(int value, std::ostream& out) {
+        char buffer[16];
+        auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.write(buffer, ptr - buffer);
+    }
+
+    // по умолчанию формат совпадает с выводом double в std::ostream (%g, 6 значащих цифр)
+    void PrintValue(double value, std::ostream& out) {
+        char buffer[32];
+        auto [ptr, ec] = shortest_doubles
+                ? std::to_chars(buffer, buffer + sizeof(buffer), value)
+                : std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+        out.write(buffer, ptr - buffer);
+    }
+
     void PrintValue(std::nullptr_t, std::ostream& out) {
         out << "null"sv;
     }
@@ -321,24 +374,7 @@ namespace json {
 
     void PrintValue(const std::string& value, std::ostream& out){
         out << '\"';
-        for(char ch : value){
-            switch (ch) {
-                case '\n':
-                    out << "\\n"sv;
-                    break;
-                case '\r':
-                    out << "\\r"sv;
-                    break;
-                case '\"':
-                    out << "\\\""sv;
-                    break;
-                case '\\':
-                    out << "\\\\"sv;
-                    break;
-                default:
-                    out << ch;
-            }
-        }
+        escape::EscapeJson(value, out);
         out << '\"';
     }
 
@@ -95,11 +95,24 @@ namespace json {
         }
     };
 
+    struct NumberParseResult {
+        const char* ptr = nullptr;
+        bool is_int = false;
+        int int_value = 0;
+        double double_value = 0;
+    };
+
+    NumberParseResult ParseNumber(const char* begin, const char* end);
+    void SetShortestDoubles(bool enabled);
+
     template <typename Value>
     void PrintValue(const Value& value, std::ostream& out) {
         out << value;
     }
 
+    void PrintValue(int value, std::ostream& out);
+    void PrintValue(double value, std::ostream& out);
+
     void PrintValue(std::nullptr_t, std::ostream& out);
     void PrintValue(bool value, std::ostream& out);
     void PrintValue(const std::string& value, std::ostream& out);
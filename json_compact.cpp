@@ -0,0 +1,555 @@
+#include "json_compact.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace json {
+namespace compact {
+
+    Arena::Arena(size_t block_size): block_size_(block_size) {}
+
+    Arena::~Arena() {
+        for (const Block& block : blocks_) {
+            memory_accounting::RecordDeallocation(memory_accounting::Subsystem::JSON_DOCUMENT, block.size);
+        }
+    }
+
+    void* Arena::Allocate(size_t size, size_t alignment) {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(current_) % alignment) % alignment;
+        if (current_ == nullptr || padding + size > left_) {
+            size_t block_size = max(block_size_, size + alignment);
+            blocks_.push_back({make_unique<char[]>(block_size), block_size});
+            bytes_reserved_ += block_size;
+            memory_accounting::RecordAllocation(memory_accounting::Subsystem::JSON_DOCUMENT, block_size);
+            current_ = blocks_.back().data.get();
+            left_ = block_size;
+            padding = (alignment - reinterpret_cast<uintptr_t>(current_) % alignment) % alignment;
+        }
+        char* result = current_ + padding;
+        current_ += padding + size;
+        left_ -= padding + size;
+        return result;
+    }
+
+    size_t Arena::BytesReserved() const {
+        return bytes_reserved_;
+    }
+
+    Value Value::MakeBool(bool value) {
+        Value result;
+        result.type_ = Type::BOOL;
+        result.bool_ = value;
+        return result;
+    }
+
+    Value Value::MakeInt(int value) {
+        Value result;
+        result.type_ = Type::INT;
+        result.int_ = value;
+        return result;
+    }
+
+    Value Value::MakeDouble(double value) {
+        Value result;
+        result.type_ = Type::DOUBLE;
+        result.double_ = value;
+        return result;
+    }
+
+    Value Value::MakeString(const char* data, uint32_t size) {
+        Value result;
+        result.type_ = Type::STRING;
+        result.size_ = size;
+        result.string_ = data;
+        return result;
+    }
+
+    Value Value::MakeArray(const Value* items, uint32_t size) {
+        Value result;
+        result.type_ = Type::ARRAY;
+        result.size_ = size;
+        result.items_ = items;
+        return result;
+    }
+
+    Value Value::MakeDict(const Member* members, uint32_t size) {
+        Value result;
+        result.type_ = Type::DICT;
+        result.size_ = size;
+        result.members_ = members;
+        return result;
+    }
+
+    bool Value::AsBool() const {
+        if (IsBool())
+            return bool_;
+        throw std::logic_error("Json Bool get error");
+    }
+
+    int Value::AsInt() const {
+        if (IsInt())
+            return int_;
+        throw std::logic_error("Json Int get error");
+    }
+
+    double Value::AsDouble() const {
+        if (IsPureDouble())
+            return double_;
+        if (IsInt())
+            return int_;
+        throw std::logic_error("Json Double get error");
+    }
+
+    std::string_view Value::AsString() const {
+        if (IsString())
+            return {string_, size_};
+        throw std::logic_error("Json String get error");
+    }
+
+    size_t Value::Size() const {
+        if (IsArray() || IsMap())
+            return size_;
+        throw std::logic_error("Json Array get error");
+    }
+
+    const Value* Value::begin() const {
+        if (IsArray())
+            return items_;
+        throw std::logic_error("Json Array get error");
+    }
+
+    const Value* Value::end() const {
+        return begin() + size_;
+    }
+
+    const Value& Value::operator[](size_t index) const {
+        if (index >= Size())
+            throw std::out_of_range("Json Array index out of range");
+        return begin()[index];
+    }
+
+    const Member* Value::MembersBegin() const {
+        if (IsMap())
+            return members_;
+        throw std::logic_error("Json Map get error");
+    }
+
+    const Member* Value::MembersEnd() const {
+        return MembersBegin() + size_;
+    }
+
+    const Value* Value::Find(std::string_view key) const {
+        for (const Member* it = MembersBegin(); it != MembersEnd(); ++it) {
+            if (it->key == key)
+                return &it->value;
+        }
+        return nullptr;
+    }
+
+    const Value& Value::At(std::string_view key) const {
+        if (const Value* value = Find(key))
+            return *value;
+        throw std::out_of_range("Json Map key not found: "s + std::string(key));
+    }
+
+    Document::Document(): arena_(make_unique<Arena>()) {}
+
+    const Value& Document::GetRoot() const {
+        return root_;
+    }
+
+    size_t Document::MemoryUsage() const {
+        size_t result = arena_->BytesReserved();
+        for (const auto& arena : thread_arenas_) {
+            result += arena->BytesReserved();
+        }
+        return result;
+    }
+
+    namespace {
+
+        // структурный просмотр массива: begin указывает на '[', результат содержит '[',
+        // все запятые верхнего уровня и закрывающую ']'; пустой вектор, если массив не закрыт
+        std::vector<const char*> FindElementBoundaries(const char* begin, const char* end) {
+            std::vector<const char*> result{begin};
+            int depth = 0;
+            for (const char* pos = begin + 1; pos != end; ++pos) {
+                switch (*pos) {
+                    case '"':
+                        for (++pos; pos != end && *pos != '"'; ++pos) {
+                            if (*pos == '\\' && ++pos == end) {
+                                return {};
+                            }
+                        }
+                        if (pos == end) {
+                            return {};
+                        }
+                        break;
+                    case '[':
+                    case '{':
+                        ++depth;
+                        break;
+                    case ']':
+                    case '}':
+                        if (depth == 0) {
+                            if (*pos != ']') {
+                                return {};
+                            }
+                            result.push_back(pos);
+                            return result;
+                        }
+                        --depth;
+                        break;
+                    case ',':
+                        if (depth == 0) {
+                            result.push_back(pos);
+                        }
+                        break;
+                }
+            }
+            return {};
+        }
+    }
+
+    class Parser {
+    public:
+        Parser(std::string_view text, Arena& arena, std::unordered_set<std::string_view>& keys,
+               Document* document, const LoadSettings& settings)
+            : pos_(text.data()), end_(text.data() + text.size()), arena_(arena), keys_(keys),
+              document_(document), settings_(settings) {}
+
+        static Document Load(std::string_view text, const LoadSettings& settings) {
+            Document document;
+            Parser parser(text, *document.arena_, document.keys_, &document, settings);
+            document.root_ = parser.ParseValue();
+            return document;
+        }
+
+        Value ParseValue() {
+            SkipWhitespace();
+            if (pos_ == end_) {
+                throw ParsingError("Failed to read from stream"s);
+            }
+            switch (*pos_) {
+                case '[':
+                    return ParseArray();
+                case '{':
+                    return ParseDict();
+                case '"':
+                    return ParseString();
+                case 't':
+                    return ParseLiteral("true"sv, Value::MakeBool(true));
+                case 'f':
+                    return ParseLiteral("false"sv, Value::MakeBool(false));
+                case 'n':
+                    return ParseLiteral("null"sv, Value());
+                default:
+                    return ParseNumber();
+            }
+        }
+
+    private:
+        void SkipWhitespace() {
+            while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t')) {
+                ++pos_;
+            }
+        }
+
+        char NextStructural() {
+            SkipWhitespace();
+            if (pos_ == end_) {
+                throw ParsingError("Unexpected end of input"s);
+            }
+            return *pos_++;
+        }
+
+        void ExpectEnd() {
+            SkipWhitespace();
+            if (pos_ != end_) {
+                throw ParsingError("Array parsing error"s);
+            }
+        }
+
+        // элементы делятся на непрерывные куски, каждый поток разбирает свой кусок в собственную арену
+        // и пишет значения сразу на их места в итоговом массиве
+        std::optional<Value> ParseArrayParallel() {
+            std::vector<const char*> bounds = FindElementBoundaries(pos_, end_);
+            if (bounds.size() < 3 || static_cast<size_t>(bounds.back() - pos_) < settings_.parallel_threshold) {
+                return std::nullopt;
+            }
+
+            size_t count = bounds.size() - 1;
+            size_t threads = std::min<size_t>(settings_.threads, count);
+            Value* items = arena_.AllocateArray<Value>(count);
+            std::vector<std::unique_ptr<Arena>> arenas(threads);
+            std::vector<std::exception_ptr> errors(threads);
+
+            auto parse_chunk = [&](size_t chunk) {
+                TC_TRACE_SCOPE("json_parse_chunk");
+                try {
+                    arenas[chunk] = make_unique<Arena>();
+                    std::unordered_set<std::string_view> keys;
+                    for (size_t i = chunk * count / threads; i < (chunk + 1) * count / threads; ++i) {
+                        Parser parser({bounds[i] + 1, static_cast<size_t>(bounds[i + 1] - bounds[i] - 1)},
+                                      *arenas[chunk], keys, nullptr, settings_);
+                        new (items + i) Value(parser.ParseValue());
+                        parser.ExpectEnd();
+                    }
+                } catch (...) {
+                    errors[chunk] = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> workers;
+            workers.reserve(threads - 1);
+            for (size_t chunk = 1; chunk < threads; ++chunk) {
+                workers.emplace_back(parse_chunk, chunk);
+            }
+            parse_chunk(0);
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+
+            for (auto& arena : arenas) {
+                if (arena) {
+                    document_->thread_arenas_.push_back(move(arena));
+                }
+            }
+            for (const std::exception_ptr& error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+            pos_ = bounds.back() + 1;
+            return Value::MakeArray(items, static_cast<uint32_t>(count));
+        }
+
+        Value ParseArray() {
+            if (document_ != nullptr && depth_ <= 1 && settings_.threads > 1
+                && static_cast<size_t>(end_ - pos_) >= settings_.parallel_threshold) {
+                if (std::optional<Value> result = ParseArrayParallel()) {
+                    return *result;
+                }
+            }
+            ++depth_;
+            ++pos_;
+            size_t base = values_.size();
+            SkipWhitespace();
+            if (pos_ != end_ && *pos_ == ']') {
+                ++pos_;
+                --depth_;
+                return Value::MakeArray(nullptr, 0);
+            }
+            while (true) {
+                values_.push_back(ParseValue());
+                char c = NextStructural();
+                if (c == ']') {
+                    break;
+                }
+                if (c != ',') {
+                    throw ParsingError("Array parsing error"s);
+                }
+            }
+
+            size_t count = values_.size() - base;
+            Value* items = arena_.AllocateArray<Value>(count);
+            std::uninitialized_copy(values_.begin() + base, values_.end(), items);
+            values_.resize(base);
+            --depth_;
+            return Value::MakeArray(items, static_cast<uint32_t>(count));
+        }
+
+        Value ParseDict() {
+            ++depth_;
+            ++pos_;
+            size_t base = members_.size();
+            SkipWhitespace();
+            if (pos_ != end_ && *pos_ == '}') {
+                ++pos_;
+                --depth_;
+                return Value::MakeDict(nullptr, 0);
+            }
+            while (true) {
+                if (NextStructural() != '"') {
+                    throw ParsingError("Dict key parsing error"s);
+                }
+                --pos_;
+                std::string_view key = InternKey(ParseRawString());
+                if (NextStructural() != ':') {
+                    throw ParsingError("Dict parsing error"s);
+                }
+                Value value = ParseValue();
+                members_.push_back({key, value});
+                char c = NextStructural();
+                if (c == '}') {
+                    break;
+                }
+                if (c != ',') {
+                    throw ParsingError("Dict parsing error"s);
+                }
+            }
+
+            size_t count = members_.size() - base;
+            Member* members = arena_.AllocateArray<Member>(count);
+            std::uninitialized_copy(members_.begin() + base, members_.end(), members);
+            members_.resize(base);
+            --depth_;
+            return Value::MakeDict(members, static_cast<uint32_t>(count));
+        }
+
+        // возвращает строку без экранирования; она живёт до следующего вызова
+        std::string_view ParseRawString() {
+            ++pos_;
+            const char* begin = pos_;
+            while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\' && *pos_ != '\n' && *pos_ != '\r') {
+                ++pos_;
+            }
+            if (pos_ != end_ && *pos_ == '"') {
+                return {begin, static_cast<size_t>(pos_++ - begin)};
+            }
+
+            scratch_.assign(begin, pos_);
+            while (true) {
+                if (pos_ == end_) {
+                    throw ParsingError("String parsing error"s);
+                }
+                const char ch = *pos_++;
+                if (ch == '"') {
+                    break;
+                } else if (ch == '\\') {
+                    if (pos_ == end_) {
+                        throw ParsingError("String parsing error"s);
+                    }
+                    const char escaped_char = *pos_++;
+                    switch (escaped_char) {
+                        case 'n':
+                            scratch_.push_back('\n');
+                            break;
+                        case 't':
+                            scratch_.push_back('\t');
+                            break;
+                        case 'r':
+                            scratch_.push_back('\r');
+                            break;
+                        case '"':
+                            scratch_.push_back('"');
+                            break;
+                        case '\\':
+                            scratch_.push_back('\\');
+                            break;
+                        default:
+                            throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                    }
+                } else if (ch == '\n' || ch == '\r') {
+                    throw ParsingError("Unexpected end of line"s);
+                } else {
+                    scratch_.push_back(ch);
+                }
+            }
+            return scratch_;
+        }
+
+        Value ParseString() {
+            std::string_view raw = ParseRawString();
+            char* data = arena_.AllocateArray<char>(raw.size());
+            std::memcpy(data, raw.data(), raw.size());
+            return Value::MakeString(data, static_cast<uint32_t>(raw.size()));
+        }
+
+        std::string_view InternKey(std::string_view raw) {
+            if (auto it = keys_.find(raw); it != keys_.end()) {
+                return *it;
+            }
+            char* data = arena_.AllocateArray<char>(raw.size());
+            std::memcpy(data, raw.data(), raw.size());
+            return *keys_.insert({data, raw.size()}).first;
+        }
+
+        Value ParseLiteral(std::string_view literal, Value value) {
+            if (static_cast<size_t>(end_ - pos_) < literal.size()
+                || std::string_view(pos_, literal.size()) != literal) {
+                throw ParsingError("String parsing error"s);
+            }
+            pos_ += literal.size();
+            return value;
+        }
+
+        Value ParseNumber() {
+            NumberParseResult result = json::ParseNumber(pos_, end_);
+            if (result.ptr == nullptr) {
+                const char* number_end = pos_;
+                while (number_end != end_ && !std::isspace(static_cast<unsigned char>(*number_end))
+                       && *number_end != ',' && *number_end != ']' && *number_end != '}') {
+                    ++number_end;
+                }
+                throw ParsingError("Failed to convert "s + std::string(pos_, number_end) + " to number"s);
+            }
+            pos_ = result.ptr;
+            return result.is_int ? Value::MakeInt(result.int_value) : Value::MakeDouble(result.double_value);
+        }
+
+        const char* pos_;
+        const char* end_;
+        Arena& arena_;
+        std::unordered_set<std::string_view>& keys_;
+        Document* document_;
+        const LoadSettings& settings_;
+        int depth_ = 0;
+        std::vector<Value> values_;
+        std::vector<Member> members_;
+        std::string scratch_;
+    };
+
+    Document Load(std::string_view text, const LoadSettings& settings) {
+        return Parser::Load(text, settings);
+    }
+
+    Document Load(std::istream& input, const LoadSettings& settings) {
+        std::string text{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+        return Load(text, settings);
+    }
+
+    Node ToNode(const Value& value) {
+        switch (value.GetType()) {
+            case Type::NUL:
+                return Node(nullptr);
+            case Type::BOOL:
+                return Node(value.AsBool());
+            case Type::INT:
+                return Node(value.AsInt());
+            case Type::DOUBLE:
+                return Node(value.AsDouble());
+            case Type::STRING:
+                return Node(std::string(value.AsString()));
+            case Type::ARRAY: {
+                Array result;
+                result.reserve(value.Size());
+                for (const Value& item : value) {
+                    result.push_back(ToNode(item));
+                }
+                return Node(move(result));
+            }
+            case Type::DICT: {
+                Dict result;
+                for (const Member* it = value.MembersBegin(); it != value.MembersEnd(); ++it) {
+                    result.insert({std::string(it->key), ToNode(it->value)});
+                }
+                return Node(move(result));
+            }
+        }
+        return Node();
+    }
+}
+}
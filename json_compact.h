@@ -0,0 +1,143 @@
+#pragma once
+
+#include "json.h"
+#include "memory_accounting.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace json {
+namespace compact {
+
+    class Arena {
+    public:
+        explicit Arena(size_t block_size = 64 * 1024);
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* Allocate(size_t size, size_t alignment);
+
+        template <typename T>
+        T* AllocateArray(size_t count) {
+            return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        size_t BytesReserved() const;
+
+    private:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t size = 0;
+        };
+
+        std::vector<Block> blocks_;
+        size_t block_size_;
+        size_t bytes_reserved_ = 0;
+        char* current_ = nullptr;
+        size_t left_ = 0;
+    };
+
+    enum class Type : uint8_t {
+        NUL,
+        BOOL,
+        INT,
+        DOUBLE,
+        STRING,
+        ARRAY,
+        DICT,
+    };
+
+    struct Member;
+
+    class Value {
+    public:
+        Value() = default;
+
+        static Value MakeBool(bool value);
+        static Value MakeInt(int value);
+        static Value MakeDouble(double value);
+        static Value MakeString(const char* data, uint32_t size);
+        static Value MakeArray(const Value* items, uint32_t size);
+        static Value MakeDict(const Member* members, uint32_t size);
+
+        Type GetType() const { return type_; }
+
+        bool IsNull() const { return type_ == Type::NUL; }
+        bool IsBool() const { return type_ == Type::BOOL; }
+        bool IsInt() const { return type_ == Type::INT; }
+        bool IsPureDouble() const { return type_ == Type::DOUBLE; }
+        bool IsDouble() const { return type_ == Type::DOUBLE || type_ == Type::INT; }
+        bool IsString() const { return type_ == Type::STRING; }
+        bool IsArray() const { return type_ == Type::ARRAY; }
+        bool IsMap() const { return type_ == Type::DICT; }
+
+        bool AsBool() const;
+        int AsInt() const;
+        double AsDouble() const;
+        std::string_view AsString() const;
+
+        size_t Size() const;
+        const Value* begin() const;
+        const Value* end() const;
+        const Value& operator[](size_t index) const;
+
+        const Member* MembersBegin() const;
+        const Member* MembersEnd() const;
+        const Value* Find(std::string_view key) const;
+        const Value& At(std::string_view key) const;
+
+    private:
+        Type type_ = Type::NUL;
+        uint32_t size_ = 0;
+        union {
+            bool bool_;
+            int int_;
+            double double_;
+            const char* string_ = nullptr;
+            const Value* items_;
+            const Member* members_;
+        };
+    };
+
+    static_assert(sizeof(Value) == 16);
+
+    struct Member {
+        std::string_view key;
+        Value value;
+    };
+
+    // threads > 1 включает параллельный разбор крупных массивов верхнего уровня
+    struct LoadSettings {
+        unsigned threads = 1;
+        size_t parallel_threshold = 1 << 20;
+    };
+
+    class Document {
+    public:
+        Document();
+
+        const Value& GetRoot() const;
+        size_t MemoryUsage() const;
+
+    private:
+        friend class Parser;
+
+        std::unique_ptr<Arena> arena_;
+        std::vector<std::unique_ptr<Arena>> thread_arenas_;
+        std::unordered_set<std::string_view> keys_;
+        Value root_;
+    };
+
+    Document Load(std::string_view text, const LoadSettings& settings = {});
+    Document Load(std::istream& input, const LoadSettings& settings = {});
+
+    Node ToNode(const Value& value);
+}
+}
@@ -1,33 +1,91 @@
 #include "json_reader.h"
+#include "compression.h"
+#include "instrumentation.h"
+#include "memory_accounting.h"
+#include "parallel.h"
+#include "response_fragments.h"
+#include "tracing.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_map>
 
-using namespace std::string_literals;
+using namespace std::literals;
 
 namespace transport_catalogue{
 namespace input{
 
-JSONReader::JSONReader(transport_catalogue::TransportCatalogue& catalogue): catalogue_(catalogue){}
+namespace {
 
-void JSONReader::AddStopToDb(const json::Dict& data){
-    if(data.at("type") == "Stop"s){
-        catalogue_.AddStop(
-                data.at("name").AsString(),
-                {data.at("latitude").AsDouble(),data.at("longitude").AsDouble()});
+std::atomic<TransportCatalogue::StopOrder> stop_order = TransportCatalogue::StopOrder::INPUT;
+
+void CheckDeltaTarget(schema::DeltaAction action, bool exists, std::string_view type, std::string_view name){
+    if(action == schema::DeltaAction::ADD && exists){
+        throw std::invalid_argument(std::string(type) + " "s + std::string(name) + " already exists"s);
+    }
+    if(action == schema::DeltaAction::MODIFY && !exists){
+        throw std::invalid_argument("Unknown "s + std::string(type) + " "s + std::string(name));
     }
 }
 
-void JSONReader::AddBusToDb(const json::Dict& data){
-    if(data.at("type") == "Bus"s){
-        catalogue_.AddBus(data.at("name").AsString(), data.at("stops").AsArray(), data.at("is_roundtrip").AsBool());
+// в JSON нет 64-битных целых: большие значения выводятся как double
+json::Node CounterNode(uint64_t value){
+    if(value <= static_cast<uint64_t>(std::numeric_limits<int>::max())){
+        return static_cast<int>(value);
     }
+    return static_cast<double>(value);
 }
 
-void JSONReader::AddDistancesToDb(const json::Dict& data){
-    if(data.at("type") == "Stop"s){
-        catalogue_.AddDistances(
-                data.at("name").AsString(), data.at("road_distances").AsMap());    // передаем словарь в функцию
+// список в ответе не растёт без предела, даже если клиент просит больше
+constexpr int MAX_LIST_LIMIT = 100;
+
+size_t ListLimit(int limit){
+    return static_cast<size_t>(std::clamp(limit, 0, MAX_LIST_LIMIT));
+}
+
+constexpr size_t NOT_PLANNED = std::numeric_limits<size_t>::max();
+
+// ответ без значения request_id: оно вставляется на позицию split
+struct PlannedAnswer{
+    std::string body;
+    size_t split = 0;
+};
+
+void CheckStopExists(const transport_catalogue::TransportCatalogue& catalogue, std::string_view stopname){
+    if(!catalogue.IsExistingStop(stopname)){
+        throw std::invalid_argument("Unknown stop "s + std::string(stopname));
+    }
+}
+
+}
+
+JSONReader::JSONReader(transport_catalogue::TransportCatalogue& catalogue)
+        : catalogue_(catalogue), writable_catalogue_(&catalogue){}
+
+JSONReader::JSONReader(const transport_catalogue::TransportCatalogue& catalogue): catalogue_(catalogue){}
+
+transport_catalogue::TransportCatalogue& JSONReader::WritableCatalogue(){
+    if(writable_catalogue_ == nullptr){
+        throw std::logic_error("Catalogue is read-only"s);
+    }
+    return *writable_catalogue_;
+}
+
+void JSONReader::AddStopToDb(const schema::StopRecord& record){
+    WritableCatalogue().AddStop(record.name, {record.latitude, record.longitude});
+}
+
+void JSONReader::AddBusToDb(const schema::BusRecord& record){
+    WritableCatalogue().AddBus(record.name, record.stops, record.is_roundtrip);
+}
+
+void JSONReader::AddDistancesToDb(const schema::StopRecord& record){
+    for(const auto& [stopname_to, distance] : record.road_distances){
+        WritableCatalogue().AddDistance(record.name, stopname_to, distance);
     }
 }
 
@@ -36,11 +94,8 @@ json::Document JSONReader::LoadJSON(const std::string& s) {
     return json::Load(strm);
 }
 
-void JSONReader::PrintBusInfo(const json::Dict& query, json::Array& response){
-    using namespace std::string_literals;
-
-    std::string busname = query.at("name").AsString();
-    auto bus_info = catalogue_.GetBusInfo(busname);
+void JSONReader::PrintBusInfo(const schema::BusQuery& query, json::Array& response) const{
+    auto bus_info = catalogue_.GetBusInfo(query.name);
 
     json::Dict bus_response;
 
@@ -52,58 +107,316 @@ void JSONReader::PrintBusInfo(const json::Dict& query, json::Array& response){
         bus_response["unique_stop_count"] = bus_info.unique_stops;
         bus_response["curvature"] = bus_info.route_length / bus_info.geo_length;
     }
-    bus_response["request_id"] = query.at("id").AsInt();
+    bus_response["request_id"] = query.id;
     response.push_back(bus_response);
 }
 
-void JSONReader::PrintStopInfo(const json::Dict& query, json::Array& response){
-    using namespace std::string_literals;
-
-    std::string stopname = query.at("name").AsString();
+void JSONReader::PrintStopInfo(const schema::StopQuery& query, json::Array& response) const{
     json::Dict stop_response;
     json::Array stops;
 
-    if(!catalogue_.IsExistingStop(stopname)){
+    if(!catalogue_.IsExistingStop(query.name)){
         stop_response["error_message"] = "not found"s;
     }else {
-        auto stop_info = catalogue_.GetStopInfo(stopname);
+        const auto& stop_info = catalogue_.GetStopInfo(query.name);
         for (const auto &bus: stop_info) {
             stops.push_back(std::string(bus));
         }
         stop_response["buses"] = stops;
+        stop_response["component_id"] = catalogue_.GetStopComponent(query.name);
     }
 
-    stop_response["request_id"] = query.at("id").AsInt();
+    stop_response["request_id"] = query.id;
     response.push_back(stop_response);
 }
 
-void JSONReader::PrintMapInfo(const json::Dict& query, const std::string& map_data, json::Array& response){
+void JSONReader::PrintMapInfo(const schema::MapQuery& query, const std::string& map_data, json::Array& response) const{
 
     json::Dict map_response;
-    map_response["map"] = map_data;
-    map_response["request_id"] = query.at("id").AsInt();
+    if(query.encoding.empty()){
+        map_response["map"] = map_data;
+    }else if(query.encoding == "gzip"sv && compression::IsSupported(compression::Format::GZIP)){
+        map_response["encoding"] = "gzip"s;
+        map_response["map"] = compression::EncodeBase64(compression::GzipCompress(map_data));
+    }else{
+        map_response["error_message"] = "unsupported encoding"s;
+    }
+    map_response["request_id"] = query.id;
 
     response.push_back(map_response);
 }
 
-void JSONReader::CreateDb(json::Dict& requests){
-    auto base_requests = requests.at("base_requests").AsArray();
+void JSONReader::PrintStatsInfo(const schema::StatsQuery& query, json::Array& response) const{
+
+    json::Dict metrics;
+    const std::vector<instrumentation::MetricSnapshot> snapshot = instrumentation::Snapshot();
+    for(const instrumentation::MetricSnapshot& metric : snapshot){
+        json::Dict values;
+        values["count"] = CounterNode(metric.count);
+        if(metric.is_timer){
+            values["total_us"] = static_cast<double>(metric.total_ns) / 1000;
+            values["max_us"] = static_cast<double>(metric.max_ns) / 1000;
+        }
+        metrics[std::string(metric.name)] = values;
+    }
+
+    json::Dict stats_response;
+    stats_response["enabled"] = instrumentation::IsEnabled();
+    stats_response["metrics"] = metrics;
+    // сколько запросов пакетов приходится на один выполненный
+    uint64_t batch_queries = snapshot[static_cast<size_t>(instrumentation::Metric::BATCH_QUERIES)].count;
+    uint64_t batch_unique = snapshot[static_cast<size_t>(instrumentation::Metric::BATCH_UNIQUE_QUERIES)].count;
+    if(batch_unique > 0){
+        stats_response["dedup_ratio"] = static_cast<double>(batch_queries) / static_cast<double>(batch_unique);
+    }
+    stats_response["request_id"] = query.id;
+
+    response.push_back(stats_response);
+}
+
+void JSONReader::PrintMemoryInfo(const schema::MemoryQuery& query, json::Array& response) const{
 
-    for(const auto& r : base_requests){
-        if(r.AsMap().at("type") == "Stop"s){
-            AddStopToDb(r.AsMap());
+    json::Dict subsystems;
+    for(const memory_accounting::SubsystemSnapshot& subsystem : memory_accounting::Snapshot()){
+        json::Dict values;
+        values["current_bytes"] = CounterNode(subsystem.current_bytes);
+        values["peak_bytes"] = CounterNode(subsystem.peak_bytes);
+        values["allocations"] = CounterNode(subsystem.allocations);
+        values["deallocations"] = CounterNode(subsystem.deallocations);
+        subsystems[std::string(subsystem.name)] = values;
+    }
+
+    json::Dict memory_response;
+    memory_response["enabled"] = memory_accounting::IsCompiledIn();
+    memory_response["current_bytes"] = CounterNode(memory_accounting::CurrentBytes());
+    memory_response["peak_bytes"] = CounterNode(memory_accounting::PeakBytes());
+    memory_response["soft_budget_bytes"] = CounterNode(memory_accounting::GetSoftBudget());
+    memory_response["subsystems"] = subsystems;
+    memory_response["request_id"] = query.id;
+
+    response.push_back(memory_response);
+}
+
+const name_search::NameIndex* JSONReader::FindNameIndex(std::string_view target) const{
+    if(target == "Stop"sv){
+        return &catalogue_.GetStopNameIndex();
+    }
+    if(target == "Bus"sv){
+        return &catalogue_.GetBusNameIndex();
+    }
+    return nullptr;
+}
+
+void JSONReader::PrintAutocomplete(const schema::AutocompleteQuery& query, json::Array& response) const{
+    json::Dict autocomplete_response;
+    if(const name_search::NameIndex* index = FindNameIndex(query.target)){
+        json::Array items;
+        for(std::string_view name : index->FindByPrefix(query.prefix, ListLimit(query.limit))){
+            items.push_back(std::string(name));
         }
+        autocomplete_response["items"] = std::move(items);
+    }else{
+        autocomplete_response["error_message"] = "unknown target"s;
     }
-    for(const auto& r : base_requests){
-        if(r.AsMap().at("type") == "Stop"s){
-            AddDistancesToDb(r.AsMap());
+    autocomplete_response["request_id"] = query.id;
+    response.push_back(autocomplete_response);
+}
+
+void JSONReader::PrintFuzzySearch(const schema::FuzzySearchQuery& query, json::Array& response) const{
+    json::Dict fuzzy_response;
+    if(const name_search::NameIndex* index = FindNameIndex(query.target)){
+        json::Array items;
+        for(const name_search::NameIndex::Match& match : index->FindSimilar(query.name, ListLimit(query.limit))){
+            json::Dict item;
+            item["name"] = std::string(match.name);
+            item["distance"] = match.distance;
+            items.push_back(std::move(item));
         }
+        fuzzy_response["items"] = std::move(items);
+    }else{
+        fuzzy_response["error_message"] = "unknown target"s;
     }
-    for(const auto& r : base_requests){
-        if(r.AsMap().at("type") == "Bus"s){
-            AddBusToDb(r.AsMap());
+    fuzzy_response["request_id"] = query.id;
+    response.push_back(fuzzy_response);
+}
+
+void JSONReader::PrintAnalytics(const schema::AnalyticsQuery& query, json::Array& response) const{
+    json::Dict analytics_response;
+    size_t limit = ListLimit(query.limit);
+    if(query.metric == "network_length"sv){
+        const auto [length, segment_count] = catalogue_.GetNetworkLength();
+        analytics_response["network_length"] = CounterNode(static_cast<uint64_t>(length));
+        analytics_response["segment_count"] = segment_count;
+    }else if(query.metric == "busiest_stops"sv){
+        json::Array items;
+        for(const TransportCatalogue::StopRank& stop : catalogue_.GetBusiestStops(limit)){
+            json::Dict item;
+            item["name"] = std::string(stop.stopname);
+            item["bus_count"] = stop.bus_count;
+            items.push_back(std::move(item));
+        }
+        analytics_response["items"] = std::move(items);
+    }else if(query.metric == "curved_routes"sv){
+        json::Array items;
+        for(const TransportCatalogue::BusRank& bus : catalogue_.GetMostCurvedBuses(limit)){
+            json::Dict item;
+            item["name"] = std::string(bus.busname);
+            item["curvature"] = bus.curvature;
+            items.push_back(std::move(item));
+        }
+        analytics_response["items"] = std::move(items);
+    }else if(query.metric == "shared_segments"sv){
+        json::Array items;
+        for(const TransportCatalogue::SegmentRank& segment : catalogue_.GetMostSharedSegments(limit)){
+            json::Dict item;
+            item["from"] = std::string(segment.from);
+            item["to"] = std::string(segment.to);
+            item["bus_count"] = segment.bus_count;
+            items.push_back(std::move(item));
         }
+        analytics_response["items"] = std::move(items);
+    }else{
+        analytics_response["error_message"] = "unknown metric"s;
     }
+    analytics_response["request_id"] = query.id;
+    response.push_back(analytics_response);
+}
+
+void JSONReader::SetStopOrder(TransportCatalogue::StopOrder order){
+    stop_order.store(order, std::memory_order_relaxed);
+}
+
+TransportCatalogue::StopOrder JSONReader::GetStopOrder(){
+    return stop_order.load(std::memory_order_relaxed);
+}
+
+void JSONReader::CreateDb(const std::vector<schema::BaseRecord>& records){
+    TC_TRACE_SCOPE("create_db");
+    // Update поверх готового каталога добавляет остановки в конец, как и дельты
+    const bool initial_build = catalogue_.GetAllStops().empty();
+    {
+        TC_SCOPED_TIMER(CREATE_DB_STOPS);
+        TC_TRACE_SCOPE("create_db_stops");
+        for(const auto& record : records){
+            if(const auto* stop = std::get_if<schema::StopRecord>(&record)){
+                AddStopToDb(*stop);
+            }
+        }
+    }
+    // при первой загрузке до расстояний и маршрутов ссылок на остановки ещё нет, и перенумеровать нужно только их самих
+    if(TransportCatalogue::StopOrder order = GetStopOrder(); initial_build && order != TransportCatalogue::StopOrder::INPUT){
+        TC_SCOPED_TIMER(CREATE_DB_REORDER);
+        TC_TRACE_SCOPE("create_db_reorder");
+        WritableCatalogue().ReorderStops(order);
+    }
+    {
+        TC_SCOPED_TIMER(CREATE_DB_DISTANCES);
+        TC_TRACE_SCOPE("create_db_distances");
+        for(const auto& record : records){
+            if(const auto* stop = std::get_if<schema::StopRecord>(&record)){
+                AddDistancesToDb(*stop);
+            }
+        }
+    }
+    {
+        TC_SCOPED_TIMER(CREATE_DB_BUSES);
+        TC_TRACE_SCOPE("create_db_buses");
+        for(const auto& record : records){
+            if(const auto* bus = std::get_if<schema::BusRecord>(&record)){
+                AddBusToDb(*bus);
+            }
+        }
+    }
+    RefreshDerivedData();
+}
+
+// изменения применяются по порядку; маршруты, затронутые изменёнными расстояниями, пересчитываются один раз в конце
+void JSONReader::ApplyDelta(const std::vector<schema::DeltaRecord>& records){
+    struct DeltaVisitor{
+        JSONReader& reader;
+        transport_catalogue::TransportCatalogue& catalogue;
+        schema::DeltaAction action;
+
+        void operator()(const schema::StopRecord& record) const{
+            CheckDeltaTarget(action, catalogue.IsExistingStop(record.name), "Stop"sv, record.name);
+            for(const auto& [stopname_to, distance] : record.road_distances){
+                if(stopname_to != record.name){
+                    CheckStopExists(catalogue, stopname_to);
+                }
+            }
+            reader.AddStopToDb(record);
+            reader.AddDistancesToDb(record);
+        }
+        void operator()(const schema::BusRecord& record) const{
+            CheckDeltaTarget(action, catalogue.FindBus(record.name) != nullptr, "Bus"sv, record.name);
+            reader.AddBusToDb(record);
+        }
+        void operator()(const schema::DistanceRecord& record) const{
+            CheckStopExists(catalogue, record.from);
+            CheckStopExists(catalogue, record.to);
+            catalogue.AddDistance(record.from, record.to, record.distance);
+        }
+        void operator()(const schema::StopRemoval& record) const{
+            catalogue.RemoveStop(record.name);
+        }
+        void operator()(const schema::BusRemoval& record) const{
+            catalogue.RemoveBus(record.name);
+        }
+        void operator()(const schema::DistanceRemoval& record) const{
+            catalogue.RemoveDistance(record.from, record.to);
+        }
+    };
+
+    TC_TRACE_SCOPE("apply_delta");
+    for(const schema::DeltaRecord& record : records){
+        std::visit(DeltaVisitor{*this, WritableCatalogue(), record.action}, record.change);
+    }
+    RefreshDerivedData();
+}
+
+void JSONReader::RefreshDerivedData(){
+    transport_catalogue::TransportCatalogue& catalogue = WritableCatalogue();
+    catalogue.RecomputeRouteLengths();
+    if(catalogue.AreComponentsStale()){
+        TC_SCOPED_TIMER(CREATE_DB_COMPONENTS);
+        TC_TRACE_SCOPE("create_db_components");
+        catalogue.ComputeStopComponents();
+    }
+    // после загрузки набор имён меняется только дельтами, а запросы ищут по именам постоянно
+    TC_SCOPED_TIMER(CREATE_DB_FREEZE);
+    TC_TRACE_SCOPE("create_db_freeze");
+    catalogue.Freeze();
+}
+
+void JSONReader::CreateDb(const json::Dict& requests){
+    const json::Array& base_requests = requests.at("base_requests").AsArray();
+    std::vector<schema::BaseRecord> records;
+    {
+        TC_SCOPED_TIMER(CREATE_DB_DECODE);
+        TC_TRACE_SCOPE("create_db_decode");
+        records.reserve(base_requests.size());
+        for(const auto& r : base_requests){
+            if(auto record = schema::DecodeBaseRecord(r.AsMap())){
+                records.push_back(std::move(*record));
+            }
+        }
+    }
+    CreateDb(records);
+}
+
+void JSONReader::CreateDb(const json::compact::Value& base_requests){
+    std::vector<schema::BaseRecord> records;
+    {
+        TC_SCOPED_TIMER(CREATE_DB_DECODE);
+        TC_TRACE_SCOPE("create_db_decode");
+        records.reserve(base_requests.Size());
+        for(const auto& r : base_requests){
+            if(auto record = schema::DecodeBaseRecord(r)){
+                records.push_back(std::move(*record));
+            }
+        }
+    }
+    CreateDb(records);
 }
 
 json::Dict JSONReader::ReadInput(std::istream& input){
@@ -115,26 +428,135 @@ json::Dict JSONReader::ReadInput(std::istream& input){
     return root;
 }
 
-void JSONReader::PrintResponse(MapRenderer& map_renderer, json::Dict& requests, std::ostream& output){
-    json::Array response_array;
-    auto stat_requests = requests.at("stat_requests").AsArray();
-    for (const auto &request: stat_requests) {
-        if (request.AsMap().at("type") == "Stop"s) {
-            PrintStopInfo(request.AsMap(), response_array);
+void JSONReader::AnswerQuery(const MapRenderer& map_renderer, const schema::StatQuery& query, json::Array& response) const{
+    struct QueryVisitor{
+        const JSONReader& reader;
+        const MapRenderer& map_renderer;
+        json::Array& response;
+
+        void operator()(const schema::BusQuery& bus_query) const{
+            TC_SCOPED_TIMER(QUERY_BUS);
+            TC_TRACE_SCOPE("Bus request");
+            reader.PrintBusInfo(bus_query, response);
+        }
+        void operator()(const schema::StopQuery& stop_query) const{
+            TC_SCOPED_TIMER(QUERY_STOP);
+            TC_TRACE_SCOPE("Stop request");
+            reader.PrintStopInfo(stop_query, response);
+        }
+        void operator()(const schema::StatsQuery& stats_query) const{
+            TC_SCOPED_TIMER(QUERY_STATS);
+            TC_TRACE_SCOPE("Stats request");
+            reader.PrintStatsInfo(stats_query, response);
+        }
+        void operator()(const schema::MemoryQuery& memory_query) const{
+            TC_SCOPED_TIMER(QUERY_MEMORY);
+            TC_TRACE_SCOPE("Memory request");
+            reader.PrintMemoryInfo(memory_query, response);
+        }
+        void operator()(const schema::AutocompleteQuery& autocomplete_query) const{
+            TC_SCOPED_TIMER(QUERY_AUTOCOMPLETE);
+            TC_TRACE_SCOPE("Autocomplete request");
+            reader.PrintAutocomplete(autocomplete_query, response);
         }
-        if (request.AsMap().at("type") == "Bus"s) {
-            PrintBusInfo(request.AsMap(), response_array);
+        void operator()(const schema::FuzzySearchQuery& fuzzy_query) const{
+            TC_SCOPED_TIMER(QUERY_FUZZY_SEARCH);
+            TC_TRACE_SCOPE("FuzzySearch request");
+            reader.PrintFuzzySearch(fuzzy_query, response);
         }
-        if (request.AsMap().at("type") == "Map"s) {
-            svg::Document doc = map_renderer.DrawMap( GetBusesOnRoute(catalogue_));
+        void operator()(const schema::AnalyticsQuery& analytics_query) const{
+            TC_SCOPED_TIMER(QUERY_ANALYTICS);
+            TC_TRACE_SCOPE("Analytics request");
+            reader.PrintAnalytics(analytics_query, response);
+        }
+        void operator()(const schema::MapQuery& map_query) const{
+            TC_SCOPED_TIMER(QUERY_MAP);
+            TC_TRACE_SCOPE("Map request");
+            svg::Document doc = map_renderer.DrawMap(GetBusesOnRoute(reader.catalogue_));
             std::stringstream ss;
             doc.Render(ss);
-            PrintMapInfo(request.AsMap(), ss.str(), response_array);
+            reader.PrintMapInfo(map_query, ss.str(), response);
         }
+    };
+    std::visit(QueryVisitor{*this, map_renderer, response}, query);
+}
+
+void JSONReader::AnswerRequest(const MapRenderer& map_renderer, const json::Dict& request, json::Array& response) const{
+    if(auto query = schema::DecodeStatQuery(request)){
+        AnswerQuery(map_renderer, *query, response);
     }
-    json::Node response(response_array);
-    json::PrintNode(response, output);
 }
 
+// одинаковые запросы пакета выполняются один раз, разные - параллельно, и ответ размножается по всем request_id.
+// Stats и Memory зависят от момента выполнения, поэтому отвечаются по порядку уже после остальных запросов пакета
+void JSONReader::PrintResponse(const MapRenderer& map_renderer, const json::Dict& requests, std::ostream& output,
+                               const ResponseFragments* fragments) const{
+    const json::Array& stat_requests = requests.at("stat_requests").AsArray();
+    std::vector<schema::StatQuery> queries;
+    // номер уникального запроса для каждого запроса пакета
+    std::vector<size_t> plan;
+    std::vector<size_t> unique;
+    {
+        TC_TRACE_SCOPE("plan_stat_requests");
+        std::unordered_map<std::string, size_t> unique_by_key;
+        queries.reserve(stat_requests.size());
+        plan.reserve(stat_requests.size());
+        for(const auto& request : stat_requests){
+            auto query = schema::DecodeStatQuery(request.AsMap());
+            if(!query){
+                continue;
+            }
+            queries.push_back(std::move(*query));
+            if(auto key = schema::QueryKey(queries.back())){
+                auto [it, inserted] = unique_by_key.try_emplace(std::move(*key), unique.size());
+                if(inserted){
+                    unique.push_back(queries.size() - 1);
+                }
+                plan.push_back(it->second);
+            }else{
+                plan.push_back(NOT_PLANNED);
+            }
+        }
+    }
+    TC_COUNT(BATCH_QUERIES, queries.size());
+    TC_COUNT(BATCH_UNIQUE_QUERIES, unique.size());
+
+    std::vector<PlannedAnswer> answers(unique.size());
+    parallel::ForEachIndex(unique.size(), [&](size_t index){
+        const schema::StatQuery& query = queries[unique[index]];
+        PlannedAnswer& answer = answers[index];
+        if(fragments != nullptr){
+            TC_SCOPED_TIMER(QUERY_FRAGMENT);
+            if(auto fragment = fragments->Find(query)){
+                answer.body.append(fragment->head).append(fragment->tail);
+                answer.split = fragment->head.size();
+                return;
+            }
+        }
+        json::Array response;
+        AnswerQuery(map_renderer, query, response);
+        answer.body = ResponseFragments::Render(response.front().AsMap(), answer.split);
+    });
+
+    json::Array response;
+    output << '[';
+    for(size_t i = 0; i < queries.size(); ++i){
+        if(i > 0){
+            output << ", "sv;
+        }
+        if(plan[i] != NOT_PLANNED){
+            const PlannedAnswer& answer = answers[plan[i]];
+            std::string_view body = answer.body;
+            ResponseFragments::Fragment{body.substr(0, answer.split), body.substr(answer.split)}
+                    .Write(std::visit([](const auto& query){ return query.id; }, queries[i]), output);
+            continue;
+        }
+        response.clear();
+        AnswerQuery(map_renderer, queries[i], response);
+        json::PrintNode(response.front(), output);
+    }
+    output << ']';
 }
+
 }
+}
\ No newline at end of file
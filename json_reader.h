@@ -5,10 +5,15 @@
 
 #include "transport_catalogue.h"
 #include "json.h"
+#include "json_compact.h"
 #include "map_renderer.h"
+#include "request_schema.h"
 
 
 namespace transport_catalogue{
+
+class ResponseFragments;
+
 namespace input{
 
 class JSONReader{
@@ -16,20 +21,42 @@ class JSONReader{
 public:
 
     JSONReader(transport_catalogue::TransportCatalogue& catalogue);
-
-    void AddStopToDb(const json::Dict& data);
-    void AddBusToDb(const json::Dict& data);
-    void AddDistancesToDb(const json::Dict& data);
-    void PrintBusInfo(const json::Dict& query, json::Array& response);
-    void PrintStopInfo(const json::Dict& query, json::Array& response);
+    // только для ответов на запросы; методы, меняющие каталог, бросают logic_error
+    explicit JSONReader(const transport_catalogue::TransportCatalogue& catalogue);
+
+    void AddStopToDb(const schema::StopRecord& record);
+    void AddBusToDb(const schema::BusRecord& record);
+    void AddDistancesToDb(const schema::StopRecord& record);
+    void PrintBusInfo(const schema::BusQuery& query, json::Array& response) const;
+    void PrintStopInfo(const schema::StopQuery& query, json::Array& response) const;
     json::Document LoadJSON(const std::string &s);
-    void CreateDb(json::Dict& requests);
+    void CreateDb(const json::Dict& requests);
+    void CreateDb(const json::compact::Value& base_requests);
+    void CreateDb(const std::vector<schema::BaseRecord>& records);
+    // порядок хранения остановок при загрузке базы; дельты и Update добавляют новые остановки в конец
+    static void SetStopOrder(TransportCatalogue::StopOrder order);
+    static TransportCatalogue::StopOrder GetStopOrder();
+    void ApplyDelta(const std::vector<schema::DeltaRecord>& records);
     json::Dict ReadInput(std::istream& input);
-    void PrintResponse(MapRenderer& map_renderer, json::Dict& root, std::ostream& output);
-    void PrintMapInfo(const json::Dict& query, const std::string& map_data, json::Array& response);
+    // ответы печатаются по одному; запросы Bus и Stop берутся из готовых фрагментов, если они переданы
+    void PrintResponse(const MapRenderer& map_renderer, const json::Dict& root, std::ostream& output,
+                       const ResponseFragments* fragments = nullptr) const;
+    void PrintMapInfo(const schema::MapQuery& query, const std::string& map_data, json::Array& response) const;
+    void PrintStatsInfo(const schema::StatsQuery& query, json::Array& response) const;
+    void PrintMemoryInfo(const schema::MemoryQuery& query, json::Array& response) const;
+    void PrintAutocomplete(const schema::AutocompleteQuery& query, json::Array& response) const;
+    void PrintFuzzySearch(const schema::FuzzySearchQuery& query, json::Array& response) const;
+    void PrintAnalytics(const schema::AnalyticsQuery& query, json::Array& response) const;
+    void AnswerRequest(const MapRenderer& map_renderer, const json::Dict& request, json::Array& response) const;
+    void AnswerQuery(const MapRenderer& map_renderer, const schema::StatQuery& query, json::Array& response) const;
 
 private:
-    transport_catalogue::TransportCatalogue& catalogue_;
+    transport_catalogue::TransportCatalogue& WritableCatalogue();
+    void RefreshDerivedData();
+    const name_search::NameIndex* FindNameIndex(std::string_view target) const;
+
+    const transport_catalogue::TransportCatalogue& catalogue_;
+    transport_catalogue::TransportCatalogue* writable_catalogue_ = nullptr;
 };
 
 }
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "catalogue_service.h"
+#include "network_server.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+struct LoadSettings{
+    std::string base_path;
+    std::string requests_path;
+    std::string socket_path;
+    int port = -1;
+    int connections = 8;
+    size_t pipeline_depth = 16;
+    size_t requests_per_connection = 0;
+    int workers = 4;
+};
+
+struct Request{
+    std::string line;
+    std::optional<int> id;
+};
+
+struct ClientConnection{
+    int fd = -1;
+    size_t sent = 0;
+    size_t received = 0;
+    std::string output;
+    size_t output_offset = 0;
+    std::string input;
+    std::deque<std::optional<int>> expected_ids;
+};
+
+void PrintUsage(std::ostream& out){
+    out << "Usage:\n"
+           "  load_generator --requests <requests.jsonl> --base <base.json> [--workers <count>]\n"
+           "  load_generator --requests <requests.jsonl> (--port <port> | --socket <path>)\n"
+           "Options: [--connections <count>] [--pipeline <depth>] [--count <requests per connection>]\n";
+}
+
+std::vector<Request> ReadRequests(const std::string& path){
+    std::ifstream input(path);
+    if(!input){
+        throw std::runtime_error("Failed to open "s + path);
+    }
+    std::vector<Request> requests;
+    std::string line;
+    while(std::getline(input, line)){
+        if(line.find_first_not_of(" \t\r") == std::string::npos){
+            continue;
+        }
+        Request request{line, std::nullopt};
+        std::istringstream strm(line);
+        json::Document document = json::Load(strm);
+        const json::Dict& query = document.GetRoot().AsMap();
+        if(query.count("id") && query.at("id").IsInt()){
+            request.id = query.at("id").AsInt();
+        }
+        requests.push_back(std::move(request));
+    }
+    if(requests.empty()){
+        throw std::runtime_error("No requests in "s + path);
+    }
+    return requests;
+}
+
+int Connect(const LoadSettings& settings, uint16_t port){
+    int fd;
+    int res;
+    if(!settings.socket_path.empty()){
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, settings.socket_path.c_str(), sizeof(address.sun_path) - 1);
+        res = connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }else{
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        res = connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+    if(fd < 0 || res < 0){
+        throw std::runtime_error("Failed to connect: "s + std::strerror(errno));
+    }
+    return fd;
+}
+
+std::optional<int> ResponseId(const std::string& line){
+    std::istringstream strm(line);
+    const json::Node root = json::Load(strm).GetRoot();
+    if(root.IsMap() && root.AsMap().count("request_id")){
+        return root.AsMap().at("request_id").AsInt();
+    }
+    return std::nullopt;
+}
+
+// каждый клиент держит до pipeline_depth запросов без ответа и проверяет порядок ответов
+size_t RunClients(const LoadSettings& settings, uint16_t port, const std::vector<Request>& requests){
+    int epoll_fd = epoll_create1(0);
+    std::vector<ClientConnection> clients(settings.connections);
+    for(size_t i = 0; i < clients.size(); ++i){
+        clients[i].fd = Connect(settings, port);
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.u64 = i;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, clients[i].fd, &event);
+    }
+
+    size_t mismatches = 0;
+    size_t finished = 0;
+    std::vector<epoll_event> events(clients.size());
+    char chunk[64 * 1024];
+    while(finished < clients.size()){
+        int count = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+        for(int e = 0; e < count; ++e){
+            ClientConnection& client = clients[events[e].data.u64];
+
+            if(events[e].events & EPOLLIN){
+                ssize_t res = recv(client.fd, chunk, sizeof(chunk), 0);
+                if(res <= 0){
+                    throw std::runtime_error("Server closed connection"s);
+                }
+                client.input.append(chunk, static_cast<size_t>(res));
+                size_t line_begin = 0;
+                for(size_t pos = client.input.find('\n'); pos != std::string::npos; pos = client.input.find('\n', line_begin)){
+                    std::optional<int> id = ResponseId(client.input.substr(line_begin, pos - line_begin));
+                    if(client.expected_ids.empty() || (client.expected_ids.front() && id != client.expected_ids.front())){
+                        ++mismatches;
+                    }
+                    if(!client.expected_ids.empty()){
+                        client.expected_ids.pop_front();
+                    }
+                    ++client.received;
+                    line_begin = pos + 1;
+                }
+                client.input.erase(0, line_begin);
+                if(client.received == settings.requests_per_connection){
+                    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client.fd, nullptr);
+                    close(client.fd);
+                    ++finished;
+                    continue;
+                }
+            }
+
+            while(client.sent < settings.requests_per_connection
+                  && client.sent - client.received < settings.pipeline_depth){
+                const Request& request = requests[client.sent % requests.size()];
+                client.output += request.line;
+                client.output += '\n';
+                client.expected_ids.push_back(request.id);
+                ++client.sent;
+            }
+            while(client.output_offset < client.output.size()){
+                ssize_t res = send(client.fd, client.output.data() + client.output_offset,
+                                   client.output.size() - client.output_offset, MSG_DONTWAIT | MSG_NOSIGNAL);
+                if(res <= 0){
+                    break;
+                }
+                client.output_offset += static_cast<size_t>(res);
+            }
+            if(client.output_offset == client.output.size()){
+                client.output.clear();
+                client.output_offset = 0;
+            }
+
+            uint32_t wanted = EPOLLIN;
+            if(!client.output.empty()){
+                wanted |= EPOLLOUT;
+            }
+            epoll_event event{};
+            event.events = wanted;
+            event.data.u64 = events[e].data.u64;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client.fd, &event);
+        }
+    }
+    close(epoll_fd);
+    return mismatches;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    LoadSettings settings;
+    for(int i = 1; i + 1 < argc; i += 2){
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if(arg == "--base"s){
+            settings.base_path = value;
+        }else if(arg == "--requests"s){
+            settings.requests_path = value;
+        }else if(arg == "--socket"s){
+            settings.socket_path = value;
+        }else if(arg == "--port"s){
+            settings.port = std::stoi(value);
+        }else if(arg == "--connections"s){
+            settings.connections = std::max(1, std::stoi(value));
+        }else if(arg == "--pipeline"s){
+            settings.pipeline_depth = std::max(1, std::stoi(value));
+        }else if(arg == "--count"s){
+            settings.requests_per_connection = std::stoul(value);
+        }else if(arg == "--workers"s){
+            settings.workers = std::stoi(value);
+        }else{
+            PrintUsage(std::cerr);
+            return 1;
+        }
+    }
+    bool in_process = settings.socket_path.empty() && settings.port < 0;
+    if(argc % 2 == 0 || settings.requests_path.empty() || (in_process && settings.base_path.empty())){
+        PrintUsage(std::cerr);
+        return 1;
+    }
+
+    std::vector<Request> requests = ReadRequests(settings.requests_path);
+    if(settings.requests_per_connection == 0){
+        settings.requests_per_connection = requests.size();
+    }
+
+    std::optional<transport_catalogue::CatalogueService> service;
+    std::optional<transport_catalogue::server::NetworkServer> network_server;
+    std::thread server_thread;
+
+    uint16_t port = static_cast<uint16_t>(std::max(settings.port, 0));
+    if(in_process){
+        std::ifstream base_file(settings.base_path, std::ios::binary);
+        if(!base_file){
+            std::cerr << "Failed to open "s << settings.base_path << std::endl;
+            return 1;
+        }
+        service.emplace(base_file);
+
+        transport_catalogue::server::NetworkServerSettings server_settings;
+        server_settings.scheduler.workers = settings.workers;
+        network_server.emplace(service->GetQueryServer(), server_settings);
+        port = network_server->ListenTcp(0);
+        server_thread = std::thread([&network_server]{ network_server->Run(); });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t mismatches = RunClients(settings, port, requests);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if(in_process){
+        network_server->Stop();
+        server_thread.join();
+    }
+
+    size_t total = settings.requests_per_connection * settings.connections;
+    std::cout << "connections: "s << settings.connections
+              << ", pipeline depth: "s << settings.pipeline_depth << '\n'
+              << "requests: "s << total << ", elapsed: "s << elapsed.count() << " s\n"s
+              << "throughput: "s << total / elapsed.count() << " req/s\n"s
+              << "out of order responses: "s << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 2;
+}
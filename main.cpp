@@ -1,22 +1,170 @@
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <string>
 
-#include "json_reader.h"
-#include "transport_catalogue.h"
+#include "catalogue_service.h"
+#include "compression.h"
+#include "instrumentation.h"
+#include "memory_accounting.h"
+#include "response_cache.h"
+#include "response_fragments.h"
+#include "tracing.h"
+#include "network_server.h"
 
+using namespace std::string_literals;
 
-int main() {
-    transport_catalogue::TransportCatalogue catalogue;
-    transport_catalogue::input::JSONReader json_reader(catalogue);
+namespace {
 
-    json::Dict input_info = json_reader.ReadInput(std::cin);
-    json_reader.CreateDb(input_info);
+void PrintUsage(std::ostream& out){
+    out << "Usage:\n"
+           "  Transport_Catalogue [--shortest-doubles] [--prerender-responses] [--stop-order <order>] [--compress-output] [--stats <format>] [--trace <trace.json>] [--memory-report <format>] < input.json[.gz]\n"
+           "  Transport_Catalogue --serve <base.json[.gz]> [--prerender-responses] [--stop-order <order>] [--compress-output] [--workers <count>] [--heavy-workers <count>] [--memory-budget <bytes>] [--response-cache-budget <bytes>]\n"
+           "  Transport_Catalogue --serve <base.json[.gz]> (--socket <path> | --port <port>) [--prerender-responses] [--stop-order <order>] [--workers <count>] [--heavy-workers <count>] [--memory-budget <bytes>] [--response-cache-budget <bytes>]\n"
+           "--stats none|json|prometheus enables timers and counters; json and prometheus also print them to stderr on exit\n"
+           "--trace <trace.json> records build and query phases and writes them in Chrome trace_event format on exit\n"
+           "--memory-report json|prometheus prints memory used by each subsystem to stderr on exit\n"
+           "--memory-budget <bytes> makes the response cache evict entries and stops the prerendered response pool from growing while accounted memory exceeds the budget\n"
+           "--response-cache-budget <bytes> limits cached Map and Analytics answers on top of --memory-budget; 0 removes the limit, the default is 64 MiB\n"
+           "--prerender-responses keeps the rendered body of every answered Bus and Stop request and reuses it\n"
+           "--stop-order input|morton|hilbert stores stops along a space-filling curve of their coordinates; answers do not change\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string base_path, socket_path;
+    int port = -1;
+    transport_catalogue::server::NetworkServerSettings network_settings;
+    bool serve = false;
+    bool compress_output = false;
+    std::string stats_format;
+    std::string trace_path;
+    std::string memory_format;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--serve"s && i + 1 < argc){
+            serve = true;
+            base_path = argv[++i];
+        }else if(arg == "--socket"s && i + 1 < argc){
+            socket_path = argv[++i];
+        }else if(arg == "--port"s && i + 1 < argc){
+            port = std::stoi(argv[++i]);
+        }else if(arg == "--shortest-doubles"s){
+            json::SetShortestDoubles(true);
+        }else if(arg == "--trace"s && i + 1 < argc){
+            trace_path = argv[++i];
+        }else if(arg == "--stats"s && i + 1 < argc){
+            stats_format = argv[++i];
+        }else if(arg == "--memory-report"s && i + 1 < argc){
+            memory_format = argv[++i];
+        }else if(arg == "--memory-budget"s && i + 1 < argc){
+            memory_accounting::SetSoftBudget(std::stoull(argv[++i]));
+        }else if(arg == "--response-cache-budget"s && i + 1 < argc){
+            transport_catalogue::server::ResponseCache::SetBudget(std::stoull(argv[++i]));
+        }else if(arg == "--prerender-responses"s){
+            transport_catalogue::ResponseFragments::SetEnabled(true);
+        }else if(arg == "--stop-order"s && i + 1 < argc){
+            std::string order = argv[++i];
+            if(order == "input"s){
+                transport_catalogue::input::JSONReader::SetStopOrder(transport_catalogue::TransportCatalogue::StopOrder::INPUT);
+            }else if(order == "morton"s){
+                transport_catalogue::input::JSONReader::SetStopOrder(transport_catalogue::TransportCatalogue::StopOrder::MORTON);
+            }else if(order == "hilbert"s){
+                transport_catalogue::input::JSONReader::SetStopOrder(transport_catalogue::TransportCatalogue::StopOrder::HILBERT);
+            }else{
+                PrintUsage(std::cerr);
+                return 1;
+            }
+        }else if(arg == "--compress-output"s){
+            compress_output = true;
+        }else if(arg == "--heavy-workers"s && i + 1 < argc){
+            network_settings.scheduler.max_heavy_running = std::stoi(argv[++i]);
+        }else if(arg == "--workers"s && i + 1 < argc){
+            network_settings.scheduler.workers = std::stoi(argv[++i]);
+        }else{
+            PrintUsage(std::cerr);
+            return 1;
+        }
+    }
+    bool network = !socket_path.empty() || port >= 0;
+    if((network && (!serve || compress_output))
+       || (!stats_format.empty() && stats_format != "none"s && stats_format != "json"s && stats_format != "prometheus"s)
+       || (!memory_format.empty() && memory_format != "json"s && memory_format != "prometheus"s)){
+        PrintUsage(std::cerr);
+        return 1;
+    }
+    if(!stats_format.empty()){
+        if(!instrumentation::IsCompiledIn()){
+            std::cerr << "Instrumentation is not compiled in, --stats is ignored"s << std::endl;
+        }
+        instrumentation::SetEnabled(true);
+    }
+    if(!trace_path.empty()){
+        tracing::Start();
+    }
+    if((!memory_format.empty() || memory_accounting::GetSoftBudget() != 0) && !memory_accounting::IsCompiledIn()){
+        std::cerr << "Memory accounting is not compiled in, --memory-report and --memory-budget are ignored"s << std::endl;
+    }
+    struct ExitDump{
+        const std::string& stats_format;
+        const std::string& trace_path;
+        const std::string& memory_format;
+        ~ExitDump(){
+            if(stats_format == "json"s){
+                instrumentation::WriteJson(std::cerr);
+            }else if(stats_format == "prometheus"s){
+                instrumentation::WritePrometheus(std::cerr);
+            }
+            if(!trace_path.empty()){
+                tracing::Stop();
+                std::ofstream trace_file(trace_path);
+                tracing::WriteChromeTrace(trace_file);
+            }
+            if(memory_format == "json"s){
+                memory_accounting::WriteJson(std::cerr);
+            }else if(memory_format == "prometheus"s){
+                memory_accounting::WritePrometheus(std::cerr);
+            }
+        }
+    } exit_dump{stats_format, trace_path, memory_format};
 
-    json::Dict render_settings = input_info.at("render_settings").AsMap();
+    std::optional<transport_catalogue::CatalogueService> service;
+    if(serve){
+        std::ifstream base_file(base_path, std::ios::binary);
+        if(!base_file){
+            std::cerr << "Failed to open "s << base_path << std::endl;
+            return 1;
+        }
+        service.emplace(base_file);
+    }else{
+        service.emplace(std::cin);
+    }
 
-    PolylineSettings ps(render_settings);
-    StopnameUnderlayerSettings ss("stop", render_settings);
-    BusnameUnderlayerSettings bs("bus", render_settings);
-    MapRenderer map_renderer(render_settings, ps, ss, bs);
+    const transport_catalogue::server::QueryServer& query_server = service->GetQueryServer();
+    if(!network){
+        std::optional<compression::GzipOutputStream> compressed;
+        if(compress_output){
+            compressed.emplace(std::cout);
+        }
+        std::ostream& output = compressed ? *compressed : std::cout;
+        if(serve){
+            query_server.ServeStream(std::cin, output);
+        }else{
+            service->PrintResponse(output);
+        }
+        if(compressed){
+            compressed->Finish();
+        }
+        return 0;
+    }
 
-    json_reader.PrintResponse(map_renderer, input_info, std::cout);
+    transport_catalogue::server::NetworkServer network_server(query_server, network_settings);
+    if(!socket_path.empty()){
+        network_server.ListenUnix(socket_path);
+    }
+    if(port >= 0){
+        std::cerr << "Listening on 127.0.0.1:"s << network_server.ListenTcp(static_cast<uint16_t>(port)) << std::endl;
+    }
+    network_server.Run();
 }
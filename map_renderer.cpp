@@ -1,4 +1,6 @@
 #include "map_renderer.h"
+#include "instrumentation.h"
+#include "tracing.h"
 
 svg::Color MakeColorFromJsonNode(const json::Node& color_node){
     if(color_node.IsString()){
@@ -39,7 +41,7 @@ PolylineSettings::PolylineSettings(const json::Dict& settings){
 void MapRenderer::DrawBusRoutePolyline(svg::Document& doc,
                           const std::vector<std::pair<std::string, svg::Point>>& bus_stops_to_coords,
                           bool is_roundtrip,
-                          int color_number){
+                          int color_number) const{
 
     svg::Polyline polyline;
     for(const auto& stop_coords : bus_stops_to_coords){
@@ -60,7 +62,7 @@ void MapRenderer::DrawBusname(svg::Document& doc,
                 svg::Point busname_pos,
                  const Bus& bus,
                  int color_number,
-                 std::vector<svg::Color>& color_palette){
+                 const std::vector<svg::Color>& color_palette) const{
 
     svg::Text routetitle_underlayer_text;
     svg::Point buslabel_offset{render_settings_.at("bus_label_offset").AsArray()[0].AsDouble(),render_settings_.at("bus_label_offset").AsArray()[1].AsDouble()};
@@ -76,7 +78,7 @@ void MapRenderer::DrawBusname(svg::Document& doc,
     doc.Add(bustitle_text.SetFillColor(color_palette[color_number]));
 }
 
-void MapRenderer::DrawStopCircle(svg::Document& doc, const std::map<std::string, svg::Point>& stops_to_coords){
+void MapRenderer::DrawStopCircle(svg::Document& doc, const std::map<std::string, svg::Point>& stops_to_coords) const{
     for(const auto& p : stops_to_coords){
         svg::Circle circle;
         circle.SetCenter(p.second).SetFillColor("white").SetRadius(render_settings_.at("stop_radius").AsDouble());
@@ -85,7 +87,7 @@ void MapRenderer::DrawStopCircle(svg::Document& doc, const std::map<std::string,
 }
 
 void MapRenderer::DrawStopname(svg::Document& doc,
-                       const std::map<std::string, svg::Point>& stops_to_coords){
+                       const std::map<std::string, svg::Point>& stops_to_coords) const{
 
     for(const auto& p : stops_to_coords){
         svg::Text stopname_underlayer_text;
@@ -101,7 +103,8 @@ void MapRenderer::DrawStopname(svg::Document& doc,
     }
 }
 
-svg::Document MapRenderer::DrawMap(const std::set<Bus>& buses){
+svg::Document MapRenderer::DrawMap(const std::set<Bus>& buses) const{
+    TC_TRACE_SCOPE("draw_map");
 
     std::map<std::string, svg::Point> stops_to_coords;
     std::map<Bus, std::vector<std::pair<std::string, svg::Point>>> screen_crds_to_buses;
@@ -110,14 +113,12 @@ svg::Document MapRenderer::DrawMap(const std::set<Bus>& buses){
 
     svg::Document doc;
 
+    // палитра не меняется при отрисовке, чтобы DrawMap можно было вызывать из нескольких потоков
+    const int palette_size = static_cast<int>(route_polyline_settings_.color_palette_.size());
     int color_num_at_palette = 0;
     for (const auto &p: screen_crds_to_buses) {
 
-        DrawBusRoutePolyline(doc, p.second, p.first.is_roundtrip, color_num_at_palette);
-
-        if (screen_crds_to_buses.size() > route_polyline_settings_.color_palette_.size()) {
-            route_polyline_settings_.color_palette_.push_back(route_polyline_settings_.color_palette_[color_num_at_palette]);
-        }
+        DrawBusRoutePolyline(doc, p.second, p.first.is_roundtrip, color_num_at_palette % palette_size);
         ++color_num_at_palette;
     }
 
@@ -126,11 +127,11 @@ svg::Document MapRenderer::DrawMap(const std::set<Bus>& buses){
     for (const auto &p: screen_crds_to_buses) {
 
         //BusnameUnderlayerSettings bnus(p.second[0].second, "bus", settings);
-        DrawBusname(doc, p.second[0].second, p.first, color_num_at_palette, route_polyline_settings_.color_palette_);
+        DrawBusname(doc, p.second[0].second, p.first, color_num_at_palette % palette_size, route_polyline_settings_.color_palette_);
 
         if ((!p.first.is_roundtrip && (p.second[0].first != p.second.back().first))) {
             //BusnameUnderlayerSettings additional_bnus(p.second.back().second, "bus", settings);
-            DrawBusname(doc, p.second.back().second, p.first, color_num_at_palette, route_polyline_settings_.color_palette_);
+            DrawBusname(doc, p.second.back().second, p.first, color_num_at_palette % palette_size, route_polyline_settings_.color_palette_);
         }
         ++color_num_at_palette;
     }
@@ -143,7 +144,8 @@ svg::Document MapRenderer::DrawMap(const std::set<Bus>& buses){
 
 std::map<Bus, std::vector<std::pair<std::string, svg::Point>>> MapRenderer::ProjectSphericalCoordsOnScreen(
         std::set<Bus> buses,
-        std::map<std::string, svg::Point>& stops_to_coords){
+        std::map<std::string, svg::Point>& stops_to_coords) const{
+    TC_SCOPED_TIMER(PROJECTION);
 
    std::vector<Coordinates> coordinates = GetStopsOnRouteCoordinates(buses);
 
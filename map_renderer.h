@@ -142,25 +142,25 @@ public:
     void DrawBusRoutePolyline(svg::Document& doc,
                   const std::vector<std::pair<std::string, svg::Point>>& bus_stops_to_coords,
                   bool is_roundtrip,
-                  int color_number);
+                  int color_number) const;
 
     void DrawBusname(svg::Document& doc,
                     svg::Point busname_pos,
                     const Bus& bus,
                     int color_number,
-                    std::vector<svg::Color>& color_palette);
+                    const std::vector<svg::Color>& color_palette) const;
 
     void DrawStopCircle(svg::Document& doc,
-                        const std::map<std::string, svg::Point>& stops_to_coords);
+                        const std::map<std::string, svg::Point>& stops_to_coords) const;
 
     void DrawStopname(svg::Document& doc,
-                    const std::map<std::string, svg::Point>& stops_to_coords);
+                    const std::map<std::string, svg::Point>& stops_to_coords) const;
 
-    svg::Document DrawMap(const std::set<Bus>& buses);
+    svg::Document DrawMap(const std::set<Bus>& buses) const;
 
     std::map<Bus, std::vector<std::pair<std::string, svg::Point>>> ProjectSphericalCoordsOnScreen(
             std::set<Bus> buses,
-            std::map<std::string, svg::Point>& stops_to_coords);
+            std::map<std::string, svg::Point>& stops_to_coords) const;
 
 private:
 
@@ -0,0 +1,142 @@
+#include "memory_accounting.h"
+
+#include <array>
+#include <atomic>
+
+using namespace std::literals;
+
+namespace memory_accounting {
+
+    namespace {
+        constexpr size_t SUBSYSTEM_COUNT = static_cast<size_t>(Subsystem::COUNT);
+
+        constexpr std::array<std::string_view, SUBSYSTEM_COUNT> SUBSYSTEM_NAMES{
+                "json_document"sv,
+                "catalogue_objects"sv,
+                "stop_name_index"sv,
+                "bus_name_index"sv,
+                "stop_buses_index"sv,
+                "distances"sv,
+                "segment_index"sv,
+                "route_lengths"sv,
+                "components"sv,
+                "frozen_name_index"sv,
+                "name_search"sv,
+                "svg"sv,
+                "response_cache"sv,
+                "response_fragments"sv,
+        };
+
+        struct alignas(64) SubsystemCell {
+            std::atomic<uint64_t> current_bytes = 0;
+            std::atomic<uint64_t> peak_bytes = 0;
+            std::atomic<uint64_t> allocations = 0;
+            std::atomic<uint64_t> deallocations = 0;
+        };
+
+        std::array<SubsystemCell, SUBSYSTEM_COUNT> cells;
+        SubsystemCell total;
+        std::atomic<uint64_t> soft_budget = 0;
+
+        void UpdatePeak(std::atomic<uint64_t>& peak, uint64_t current) {
+            uint64_t max = peak.load(std::memory_order_relaxed);
+            while (current > max && !peak.compare_exchange_weak(max, current, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    namespace detail {
+        void Allocated(Subsystem subsystem, size_t bytes) {
+            SubsystemCell& cell = cells[static_cast<size_t>(subsystem)];
+            cell.allocations.fetch_add(1, std::memory_order_relaxed);
+            UpdatePeak(cell.peak_bytes, cell.current_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+            UpdatePeak(total.peak_bytes, total.current_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+        }
+
+        void Deallocated(Subsystem subsystem, size_t bytes) {
+            SubsystemCell& cell = cells[static_cast<size_t>(subsystem)];
+            cell.deallocations.fetch_add(1, std::memory_order_relaxed);
+            cell.current_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            total.current_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    bool IsCompiledIn() {
+#ifdef TC_ENABLE_MEMORY_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void SetSoftBudget(uint64_t bytes) {
+        soft_budget.store(bytes, std::memory_order_relaxed);
+    }
+
+    uint64_t GetSoftBudget() {
+        return soft_budget.load(std::memory_order_relaxed);
+    }
+
+    uint64_t CurrentBytes() {
+        return total.current_bytes.load(std::memory_order_relaxed);
+    }
+
+    uint64_t PeakBytes() {
+        return total.peak_bytes.load(std::memory_order_relaxed);
+    }
+
+    bool IsOverBudget() {
+        uint64_t budget = GetSoftBudget();
+        return budget != 0 && CurrentBytes() > budget;
+    }
+
+    std::vector<SubsystemSnapshot> Snapshot() {
+        std::vector<SubsystemSnapshot> result;
+        result.reserve(SUBSYSTEM_COUNT);
+        for (size_t i = 0; i < SUBSYSTEM_COUNT; ++i) {
+            result.push_back({SUBSYSTEM_NAMES[i],
+                              cells[i].current_bytes.load(std::memory_order_relaxed),
+                              cells[i].peak_bytes.load(std::memory_order_relaxed),
+                              cells[i].allocations.load(std::memory_order_relaxed),
+                              cells[i].deallocations.load(std::memory_order_relaxed)});
+        }
+        return result;
+    }
+
+    void WritePrometheus(std::ostream& out) {
+        std::vector<SubsystemSnapshot> snapshot = Snapshot();
+        out << "# TYPE tc_memory_bytes gauge\n"sv;
+        for (const SubsystemSnapshot& subsystem : snapshot) {
+            out << "tc_memory_bytes{subsystem=\""sv << subsystem.name << "\"} "sv << subsystem.current_bytes << '\n';
+        }
+        out << "# TYPE tc_memory_peak_bytes gauge\n"sv;
+        for (const SubsystemSnapshot& subsystem : snapshot) {
+            out << "tc_memory_peak_bytes{subsystem=\""sv << subsystem.name << "\"} "sv << subsystem.peak_bytes << '\n';
+        }
+        out << "# TYPE tc_memory_allocations_total counter\n"sv;
+        for (const SubsystemSnapshot& subsystem : snapshot) {
+            out << "tc_memory_allocations_total{subsystem=\""sv << subsystem.name << "\"} "sv << subsystem.allocations << '\n';
+        }
+        out << "# TYPE tc_memory_total_bytes gauge\n"sv
+            << "tc_memory_total_bytes "sv << CurrentBytes() << '\n'
+            << "# TYPE tc_memory_total_peak_bytes gauge\n"sv
+            << "tc_memory_total_peak_bytes "sv << PeakBytes() << '\n'
+            << "# TYPE tc_memory_soft_budget_bytes gauge\n"sv
+            << "tc_memory_soft_budget_bytes "sv << GetSoftBudget() << '\n';
+        out.flush();
+    }
+
+    void WriteJson(std::ostream& out) {
+        out << "{\"current_bytes\": "sv << CurrentBytes() << ", \"peak_bytes\": "sv << PeakBytes()
+            << ", \"soft_budget_bytes\": "sv << GetSoftBudget() << ", \"subsystems\": {"sv;
+        bool first = true;
+        for (const SubsystemSnapshot& subsystem : Snapshot()) {
+            out << (first ? ""sv : ", "sv) << '"' << subsystem.name << "\": {\"current_bytes\": "sv << subsystem.current_bytes
+                << ", \"peak_bytes\": "sv << subsystem.peak_bytes << ", \"allocations\": "sv << subsystem.allocations
+                << ", \"deallocations\": "sv << subsystem.deallocations << '}';
+            first = false;
+        }
+        out << "}}\n"sv;
+        out.flush();
+    }
+}
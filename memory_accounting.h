@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace memory_accounting {
+
+    enum class Subsystem : uint8_t {
+        JSON_DOCUMENT,
+        CATALOGUE_OBJECTS,
+        STOP_NAME_INDEX,
+        BUS_NAME_INDEX,
+        STOP_BUSES_INDEX,
+        DISTANCES,
+        SEGMENT_INDEX,
+        ROUTE_LENGTHS,
+        COMPONENTS,
+        FROZEN_NAME_INDEX,
+        NAME_SEARCH,
+        SVG,
+        RESPONSE_CACHE,
+        RESPONSE_FRAGMENTS,
+        COUNT,
+    };
+
+    struct SubsystemSnapshot {
+        std::string_view name;
+        uint64_t current_bytes = 0;
+        uint64_t peak_bytes = 0;
+        uint64_t allocations = 0;
+        uint64_t deallocations = 0;
+    };
+
+    namespace detail {
+        void Allocated(Subsystem subsystem, size_t bytes);
+        void Deallocated(Subsystem subsystem, size_t bytes);
+    }
+
+    // без TC_ENABLE_MEMORY_STATS учёт сводится к пустым вызовам, а бюджет никогда не превышается
+    inline void RecordAllocation(Subsystem subsystem, size_t bytes) {
+#ifdef TC_ENABLE_MEMORY_STATS
+        detail::Allocated(subsystem, bytes);
+#else
+        (void)subsystem;
+        (void)bytes;
+#endif
+    }
+
+    inline void RecordDeallocation(Subsystem subsystem, size_t bytes) {
+#ifdef TC_ENABLE_MEMORY_STATS
+        detail::Deallocated(subsystem, bytes);
+#else
+        (void)subsystem;
+        (void)bytes;
+#endif
+    }
+
+    bool IsCompiledIn();
+
+    // мягкий бюджет не ограничивает выделения, а только заставляет кэш ответов вытеснять записи
+    // и останавливает рост пула готовых ответов; 0 - без ограничения
+    void SetSoftBudget(uint64_t bytes);
+    uint64_t GetSoftBudget();
+    uint64_t CurrentBytes();
+    uint64_t PeakBytes();
+    bool IsOverBudget();
+
+    std::vector<SubsystemSnapshot> Snapshot();
+    void WritePrometheus(std::ostream& out);
+    void WriteJson(std::ostream& out);
+
+    // аллокатор без состояния для стандартных контейнеров: память берётся у std::allocator и записывается на подсистему
+    template <typename T, Subsystem S>
+    class Allocator {
+    public:
+        using value_type = T;
+
+        template <typename U>
+        struct rebind {
+            using other = Allocator<U, S>;
+        };
+
+        Allocator() noexcept = default;
+
+        template <typename U>
+        Allocator(const Allocator<U, S>&) noexcept {}
+
+        T* allocate(size_t count) {
+            T* result = std::allocator<T>().allocate(count);
+            RecordAllocation(S, count * sizeof(T));
+            return result;
+        }
+
+        void deallocate(T* ptr, size_t count) noexcept {
+            RecordDeallocation(S, count * sizeof(T));
+            std::allocator<T>().deallocate(ptr, count);
+        }
+
+        template <typename U>
+        bool operator==(const Allocator<U, S>&) const noexcept {
+            return true;
+        }
+
+        template <typename U>
+        bool operator!=(const Allocator<U, S>&) const noexcept {
+            return false;
+        }
+    };
+}
@@ -0,0 +1,395 @@
+#include "name_search.h"
+#include "flat_hash_map.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace name_search {
+
+    namespace {
+        // столько шагов слияния списков триграмм делается на один запрос
+        constexpr size_t MERGE_STEP_BUDGET = 4096;
+        // столько кандидатов с наибольшим числом общих триграмм проверяется точным расстоянием
+        constexpr size_t VERIFY_LIMIT = 32;
+        constexpr int MAX_DISTANCE = 3;
+        // одна правка меняет не больше трёх триграмм
+        constexpr int TRIGRAMS_PER_EDIT = 3;
+
+        // регистр сворачивается только у латиницы: остальные буквы сравниваются побайтно
+        unsigned char Fold(char c) {
+            return c >= 'A' && c <= 'Z' ? static_cast<unsigned char>(c - 'A' + 'a') : static_cast<unsigned char>(c);
+        }
+
+        int CompareFolded(std::string_view lhs, std::string_view rhs) {
+            size_t size = std::min(lhs.size(), rhs.size());
+            for (size_t i = 0; i < size; ++i) {
+                unsigned char l = Fold(lhs[i]);
+                unsigned char r = Fold(rhs[i]);
+                if (l != r) {
+                    return l < r ? -1 : 1;
+                }
+            }
+            return lhs.size() < rhs.size() ? -1 : (lhs.size() > rhs.size() ? 1 : 0);
+        }
+
+        bool StartsWithFolded(std::string_view name, std::string_view prefix) {
+            return name.size() >= prefix.size() && CompareFolded(name.substr(0, prefix.size()), prefix) == 0;
+        }
+
+        // имена, различающиеся только регистром, упорядочиваются побайтно, чтобы порядок был однозначным
+        bool LessName(std::string_view lhs, std::string_view rhs) {
+            int compare = CompareFolded(lhs, rhs);
+            return compare != 0 ? compare < 0 : lhs < rhs;
+        }
+
+        // имя дополняется двумя нулевыми байтами слева и одним справа, поэтому начало и конец имени тоже дают триграммы
+        void CollectTrigrams(std::string_view name, std::vector<uint32_t>& trigrams) {
+            trigrams.clear();
+            uint32_t window = 0;
+            for (size_t i = 0; i <= name.size(); ++i) {
+                unsigned char c = i < name.size() ? Fold(name[i]) : 0;
+                window = ((window << 8) | c) & 0xffffffu;
+                trigrams.push_back(window);
+            }
+            std::sort(trigrams.begin(), trigrams.end());
+            trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+        }
+
+        // расстояние считается по кодовым точкам UTF-8, чтобы опечатка в кириллице стоила одной правки
+        void DecodeFolded(std::string_view text, std::vector<uint32_t>& points) {
+            points.clear();
+            for (size_t i = 0; i < text.size();) {
+                auto lead = static_cast<unsigned char>(text[i]);
+                size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xe ? 3 : (lead >> 3) == 0x1e ? 4 : 1;
+                if (i + length > text.size()) {
+                    length = 1;
+                }
+                uint32_t point = length == 1 ? Fold(text[i]) : lead & (0x7fu >> length);
+                for (size_t k = 1; k < length; ++k) {
+                    point = (point << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3fu);
+                }
+                points.push_back(point);
+                i += length;
+            }
+        }
+
+        // расстояние Левенштейна в полосе шириной limit вокруг диагонали; за пределами полосы ответ заведомо больше limit,
+        // и тогда возвращается limit + 1
+        int BoundedDistance(const std::vector<uint32_t>& lhs, const std::vector<uint32_t>& rhs, int limit, std::vector<int>& row) {
+            const int lhs_size = static_cast<int>(lhs.size());
+            const int rhs_size = static_cast<int>(rhs.size());
+            const int out_of_band = limit + 1;
+            if (std::abs(lhs_size - rhs_size) > limit) {
+                return out_of_band;
+            }
+            row.assign(rhs_size + 1, out_of_band);
+            for (int j = 0; j <= std::min(rhs_size, limit); ++j) {
+                row[j] = j;
+            }
+            for (int i = 1; i <= lhs_size; ++i) {
+                const int from = std::max(1, i - limit);
+                const int to = std::min(rhs_size, i + limit);
+                int diagonal = row[from - 1];
+                int left = from == 1 && i <= limit ? i : out_of_band;
+                row[from - 1] = left;
+                int row_min = left;
+                for (int j = from; j <= to; ++j) {
+                    int current = std::min({row[j] + 1, left + 1, diagonal + (lhs[i - 1] != rhs[j - 1] ? 1 : 0), out_of_band});
+                    diagonal = row[j];
+                    row[j] = current;
+                    left = current;
+                    row_min = std::min(row_min, current);
+                }
+                if (row_min > limit) {
+                    return out_of_band;
+                }
+            }
+            return row[rhs_size];
+        }
+        struct PostingCursor {
+            const uint32_t* current;
+            const uint32_t* end;
+        };
+
+        // первая позиция не меньше target: шаг удваивается, пока не перепрыгнет её, затем двоичный поиск
+        const uint32_t* Gallop(const uint32_t* begin, const uint32_t* end, uint32_t target) {
+            size_t size = end - begin;
+            size_t bound = 1;
+            while (bound < size && begin[bound] < target) {
+                bound *= 2;
+            }
+            return std::lower_bound(begin + bound / 2, begin + std::min(bound + 1, size), target);
+        }
+
+        // слияние отсортированных списков с пропуском: если наименьший номер встречается меньше чем в min_shared списках,
+        // min_shared - 1 самых отстающих списков сразу перематываются к min_shared-му по порядку голове,
+        // поэтому длинные списки частых триграмм почти не читаются
+        void MergeCandidates(std::vector<PostingCursor>& heap, size_t min_shared, std::vector<std::pair<uint32_t, uint32_t>>& candidates) {
+            auto later = [](const PostingCursor& lhs, const PostingCursor& rhs) {
+                return *lhs.current > *rhs.current;
+            };
+            std::make_heap(heap.begin(), heap.end(), later);
+            std::vector<PostingCursor> popped;
+            auto pop = [&heap, &popped, &later] {
+                std::pop_heap(heap.begin(), heap.end(), later);
+                popped.push_back(heap.back());
+                heap.pop_back();
+            };
+            for (size_t step = 0; step < MERGE_STEP_BUDGET && heap.size() >= min_shared; ++step) {
+                uint32_t index = *heap.front().current;
+                popped.clear();
+                while (!heap.empty() && *heap.front().current == index) {
+                    pop();
+                }
+                if (popped.size() >= min_shared) {
+                    candidates.emplace_back(static_cast<uint32_t>(popped.size()), index);
+                    for (PostingCursor& cursor : popped) {
+                        ++cursor.current;
+                    }
+                } else {
+                    while (popped.size() + 1 < min_shared) {
+                        pop();
+                    }
+                    uint32_t target = *heap.front().current;
+                    for (PostingCursor& cursor : popped) {
+                        cursor.current = Gallop(cursor.current, cursor.end, target);
+                    }
+                }
+                for (const PostingCursor& cursor : popped) {
+                    if (cursor.current != cursor.end) {
+                        heap.push_back(cursor);
+                        std::push_heap(heap.begin(), heap.end(), later);
+                    }
+                }
+            }
+        }
+    }
+
+    NameIndex::NameIndex(const std::vector<std::string_view>& names) {
+        size_t text_size = 0;
+        for (std::string_view name : names) {
+            text_size += name.size();
+        }
+        if (text_size > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("Name index is too large");
+        }
+
+        // свёрнутые копии нужны только на время построения: с ними сортировка сравнивает байты без преобразований
+        std::string folded;
+        folded.reserve(text_size);
+        std::vector<std::string_view> folded_names;
+        folded_names.reserve(names.size());
+        std::vector<uint32_t> lengths;
+        lengths.reserve(names.size());
+        std::vector<uint32_t> points;
+        for (std::string_view name : names) {
+            for (char c : name) {
+                folded.push_back(static_cast<char>(Fold(c)));
+            }
+            DecodeFolded(name, points);
+            lengths.push_back(static_cast<uint32_t>(points.size()));
+        }
+        for (size_t i = 0, offset = 0; i < names.size(); offset += names[i].size(), ++i) {
+            folded_names.push_back(std::string_view(folded).substr(offset, names[i].size()));
+        }
+
+        struct SortKey {
+            std::string_view folded;
+            std::string_view name;
+            uint32_t original;
+        };
+        std::vector<SortKey> sort_keys;
+        sort_keys.reserve(names.size());
+        for (uint32_t original = 0; original < names.size(); ++original) {
+            sort_keys.push_back({folded_names[original], names[original], original});
+        }
+        std::sort(sort_keys.begin(), sort_keys.end(), [](const SortKey& lhs, const SortKey& rhs) {
+            int compare = lhs.folded.compare(rhs.folded);
+            return compare != 0 ? compare < 0 : lhs.name < rhs.name;
+        });
+        std::vector<uint32_t> by_name;
+        by_name.reserve(names.size());
+        for (const SortKey& key : sort_keys) {
+            by_name.push_back(key.original);
+        }
+
+        // устойчивая сортировка подсчётом по длине сохраняет алфавитный порядок внутри каждой длины
+        uint32_t max_length = lengths.empty() ? 0 : *std::max_element(lengths.begin(), lengths.end());
+        length_begin_.assign(max_length + 2, 0);
+        for (uint32_t length : lengths) {
+            ++length_begin_[length + 1];
+        }
+        for (size_t length = 1; length < length_begin_.size(); ++length) {
+            length_begin_[length] += length_begin_[length - 1];
+        }
+        std::vector<uint32_t> index_of(names.size());
+        std::vector<uint32_t> next_index(length_begin_.begin(), length_begin_.end() - 1);
+        for (uint32_t original : by_name) {
+            index_of[original] = next_index[lengths[original]]++;
+        }
+
+        std::vector<uint32_t> by_index(names.size());
+        for (uint32_t original = 0; original < names.size(); ++original) {
+            by_index[index_of[original]] = original;
+        }
+        text_.reserve(text_size);
+        name_begin_.reserve(names.size() + 1);
+        for (uint32_t original : by_index) {
+            name_begin_.push_back(static_cast<uint32_t>(text_.size()));
+            text_.insert(text_.end(), names[original].begin(), names[original].end());
+        }
+        name_begin_.push_back(static_cast<uint32_t>(text_.size()));
+
+        alphabetical_.reserve(names.size());
+        for (uint32_t original : by_name) {
+            alphabetical_.push_back(index_of[original]);
+        }
+
+        // триграммы каждого имени ищутся в таблице один раз: вхождение запоминает предварительный номер триграммы,
+        // который после сортировки триграмм переводится в окончательный
+        flat_hash::FlatHashMap<uint32_t, uint32_t> provisional_slot;
+        std::vector<uint32_t> occurrences;
+        std::vector<uint32_t> occurrence_begin;
+        occurrence_begin.reserve(size() + 1);
+        std::vector<uint32_t> name_trigrams;
+        for (uint32_t index = 0; index < size(); ++index) {
+            occurrence_begin.push_back(static_cast<uint32_t>(occurrences.size()));
+            CollectTrigrams(Name(index), name_trigrams);
+            for (uint32_t trigram : name_trigrams) {
+                auto [it, inserted] = provisional_slot.try_emplace(trigram, static_cast<uint32_t>(trigrams_.size()));
+                if (inserted) {
+                    trigrams_.push_back(trigram);
+                }
+                occurrences.push_back(it->second);
+            }
+        }
+        occurrence_begin.push_back(static_cast<uint32_t>(occurrences.size()));
+
+        std::vector<uint32_t> by_trigram(trigrams_.size());
+        std::iota(by_trigram.begin(), by_trigram.end(), 0);
+        std::sort(by_trigram.begin(), by_trigram.end(), [this](uint32_t lhs, uint32_t rhs) {
+            return trigrams_[lhs] < trigrams_[rhs];
+        });
+        std::vector<uint32_t> final_slot(trigrams_.size());
+        for (uint32_t slot = 0; slot < by_trigram.size(); ++slot) {
+            final_slot[by_trigram[slot]] = slot;
+        }
+        std::sort(trigrams_.begin(), trigrams_.end());
+
+        // номера имён в каждом списке растут, потому что имена обходятся по порядку
+        posting_begin_.assign(trigrams_.size() + 1, 0);
+        for (uint32_t& slot : occurrences) {
+            slot = final_slot[slot];
+            ++posting_begin_[slot + 1];
+        }
+        for (size_t slot = 1; slot < posting_begin_.size(); ++slot) {
+            posting_begin_[slot] += posting_begin_[slot - 1];
+        }
+        postings_.resize(occurrences.size());
+        std::vector<uint32_t> cursor(posting_begin_.begin(), posting_begin_.end() - 1);
+        for (uint32_t index = 0; index < size(); ++index) {
+            for (uint32_t i = occurrence_begin[index]; i < occurrence_begin[index + 1]; ++i) {
+                postings_[cursor[occurrences[i]]++] = index;
+            }
+        }
+    }
+
+    std::string_view NameIndex::Name(uint32_t index) const {
+        return {text_.data() + name_begin_[index], name_begin_[index + 1] - name_begin_[index]};
+    }
+
+    std::pair<uint32_t, uint32_t> NameIndex::Postings(uint32_t trigram) const {
+        auto it = std::lower_bound(trigrams_.begin(), trigrams_.end(), trigram);
+        if (it == trigrams_.end() || *it != trigram) {
+            return {0, 0};
+        }
+        size_t slot = it - trigrams_.begin();
+        return {posting_begin_[slot], posting_begin_[slot + 1]};
+    }
+
+    std::vector<std::string_view> NameIndex::FindByPrefix(std::string_view prefix, size_t limit) const {
+        auto first = std::partition_point(alphabetical_.begin(), alphabetical_.end(), [this, prefix](uint32_t index) {
+            return CompareFolded(Name(index), prefix) < 0;
+        });
+        std::vector<std::string_view> result;
+        for (auto it = first; it != alphabetical_.end() && result.size() < limit && StartsWithFolded(Name(*it), prefix); ++it) {
+            result.push_back(Name(*it));
+        }
+        return result;
+    }
+
+    std::vector<NameIndex::Match> NameIndex::FindSimilar(std::string_view query, size_t limit) const {
+        std::vector<Match> result;
+        if (query.empty() || limit == 0 || size() == 0) {
+            return result;
+        }
+        std::vector<uint32_t> query_points;
+        DecodeFolded(query, query_points);
+        std::vector<uint32_t> query_trigrams;
+        CollectTrigrams(query, query_trigrams);
+        std::vector<std::pair<uint32_t, uint32_t>> lists;
+        lists.reserve(query_trigrams.size());
+        for (uint32_t trigram : query_trigrams) {
+            if (auto list = Postings(trigram); list.first != list.second) {
+                lists.push_back(list);
+            }
+        }
+
+        // допуск растёт, только пока совпадений нет: при малом допуске порог общих триграмм высокий,
+        // и слияние пропускает почти все списки
+        const int query_length = static_cast<int>(query_points.size());
+        const int max_length = static_cast<int>(length_begin_.size()) - 2;
+        const int max_distance = std::min(MAX_DISTANCE, 1 + query_length / 6);
+        std::vector<std::pair<int, uint32_t>> matches;
+        std::vector<PostingCursor> heap;
+        std::vector<std::pair<uint32_t, uint32_t>> candidates;
+        std::vector<uint32_t> name_points;
+        std::vector<int> row;
+        for (int distance_limit = 1; distance_limit <= max_distance && matches.empty(); ++distance_limit) {
+            // номера имён упорядочены по длине, поэтому фильтр по длине сужает каждый список до отрезка
+            int shortest = std::max(0, query_length - distance_limit);
+            int longest = std::min(max_length, query_length + distance_limit);
+            if (shortest > longest) {
+                continue;
+            }
+            const uint32_t* data = postings_.data();
+            heap.clear();
+            for (auto [begin, end] : lists) {
+                const uint32_t* first = std::lower_bound(data + begin, data + end, length_begin_[shortest]);
+                const uint32_t* last = std::lower_bound(first, data + end, length_begin_[longest + 1]);
+                if (first != last) {
+                    heap.push_back({first, last});
+                }
+            }
+            // имя в пределах distance_limit правок делит с запросом не меньше min_shared триграмм
+            int min_shared = std::max(1, static_cast<int>(query_trigrams.size()) - TRIGRAMS_PER_EDIT * distance_limit);
+            candidates.clear();
+            MergeCandidates(heap, static_cast<size_t>(min_shared), candidates);
+
+            size_t verified = std::min(candidates.size(), VERIFY_LIMIT);
+            std::nth_element(candidates.begin(), candidates.begin() + verified, candidates.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.first != rhs.first ? lhs.first > rhs.first : lhs.second < rhs.second;
+            });
+            candidates.resize(verified);
+
+            for (const auto& candidate : candidates) {
+                DecodeFolded(Name(candidate.second), name_points);
+                int distance = BoundedDistance(query_points, name_points, distance_limit, row);
+                if (distance <= distance_limit) {
+                    matches.emplace_back(distance, candidate.second);
+                }
+            }
+        }
+        std::sort(matches.begin(), matches.end(), [this](const auto& lhs, const auto& rhs) {
+            return lhs.first != rhs.first ? lhs.first < rhs.first : LessName(Name(lhs.second), Name(rhs.second));
+        });
+        for (size_t i = 0; i < matches.size() && i < limit; ++i) {
+            result.push_back({Name(matches[i].second), matches[i].first});
+        }
+        return result;
+    }
+}
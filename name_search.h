@@ -0,0 +1,55 @@
+#pragma once
+
+#include "memory_accounting.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace name_search {
+
+    // поисковый индекс по неизменному набору имён: строится один раз и дальше только читается.
+    // имена хранятся в одном буфере, упорядоченные по длине в кодовых точках, а внутри длины - по алфавиту
+    // без учёта регистра латиницы; отдельная перестановка задаёт чисто алфавитный порядок для поиска по префиксу.
+    // для нечёткого поиска хранится инвертированный индекс триграмм: триграмма -> номера имён по возрастанию
+    class NameIndex {
+    public:
+        struct Match {
+            std::string_view name;
+            int distance = 0;
+        };
+
+        NameIndex() = default;
+        // имена должны быть различными; индекс хранит их копию
+        explicit NameIndex(const std::vector<std::string_view>& names);
+
+        // до limit имён, начинающихся с prefix, в алфавитном порядке
+        std::vector<std::string_view> FindByPrefix(std::string_view prefix, size_t limit) const;
+        // до limit имён с наименьшим расстоянием редактирования, при равенстве - по алфавиту.
+        // допуск начинается с одной правки и растёт до трёх, пока ничего не найдено; число шагов слияния ограничено,
+        // поэтому в худшем случае часть кандидатов может быть пропущена
+        std::vector<Match> FindSimilar(std::string_view query, size_t limit) const;
+
+        size_t size() const {
+            return name_begin_.empty() ? 0 : name_begin_.size() - 1;
+        }
+
+    private:
+        template <typename T>
+        using TrackedVector = std::vector<T, memory_accounting::Allocator<T, memory_accounting::Subsystem::NAME_SEARCH>>;
+
+        std::string_view Name(uint32_t index) const;
+        std::pair<uint32_t, uint32_t> Postings(uint32_t trigram) const;
+
+        TrackedVector<char> text_;
+        TrackedVector<uint32_t> name_begin_;
+        // имена длины l занимают номера [length_begin_[l], length_begin_[l + 1])
+        TrackedVector<uint32_t> length_begin_;
+        TrackedVector<uint32_t> alphabetical_;
+        TrackedVector<uint32_t> trigrams_;
+        TrackedVector<uint32_t> posting_begin_;
+        TrackedVector<uint32_t> postings_;
+    };
+}
@@ -0,0 +1,421 @@
+#include "network_server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std::string_literals;
+
+namespace transport_catalogue{
+namespace server{
+
+namespace {
+
+const uint64_t WAKE_ID = 0;
+const size_t READ_CHUNK_SIZE = 64 * 1024;
+
+std::runtime_error SystemError(const std::string& what){
+    return std::runtime_error(what + ": "s + std::strerror(errno));
+}
+
+void SetNonBlocking(int fd){
+    int flags = fcntl(fd, F_GETFL, 0);
+    if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0){
+        throw SystemError("Failed to make socket non-blocking"s);
+    }
+}
+
+}
+
+NetworkServer::NetworkServer(const QueryServer& query_server, NetworkServerSettings settings)
+        : query_server_(query_server), settings_(settings){
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if(epoll_fd_ < 0){
+        throw SystemError("Failed to create epoll instance"s);
+    }
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(wake_fd_ < 0){
+        close(epoll_fd_);
+        throw SystemError("Failed to create eventfd"s);
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_ID;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    scheduler_.emplace(settings_.scheduler);
+}
+
+NetworkServer::~NetworkServer(){
+    scheduler_.reset();
+    for(const auto& [id, connection] : connections_){
+        close(connection->fd);
+    }
+    for(const auto& [id, fd] : listeners_){
+        close(fd);
+    }
+    if(!unix_socket_path_.empty()){
+        unlink(unix_socket_path_.c_str());
+    }
+    close(wake_fd_);
+    close(epoll_fd_);
+}
+
+uint16_t NetworkServer::ListenTcp(uint16_t port){
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0){
+        throw SystemError("Failed to create socket"s);
+    }
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    socklen_t address_size = sizeof(address);
+    if(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+       || listen(fd, SOMAXCONN) < 0
+       || getsockname(fd, reinterpret_cast<sockaddr*>(&address), &address_size) < 0){
+        auto error = SystemError("Failed to listen on port "s + std::to_string(port));
+        close(fd);
+        throw error;
+    }
+    AddListenSocket(fd);
+    return ntohs(address.sin_port);
+}
+
+void NetworkServer::ListenUnix(const std::string& socket_path){
+    sockaddr_un address{};
+    if(socket_path.size() >= sizeof(address.sun_path)){
+        throw std::invalid_argument("Socket path is too long: "s + socket_path);
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0){
+        throw SystemError("Failed to create socket"s);
+    }
+    unlink(socket_path.c_str());
+    if(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+       || listen(fd, SOMAXCONN) < 0){
+        auto error = SystemError("Failed to listen on "s + socket_path);
+        close(fd);
+        throw error;
+    }
+    unix_socket_path_ = socket_path;
+    AddListenSocket(fd);
+}
+
+void NetworkServer::AddListenSocket(int fd){
+    SetNonBlocking(fd);
+    uint64_t id = next_id_++;
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = id;
+    if(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0){
+        close(fd);
+        throw SystemError("Failed to register listening socket"s);
+    }
+    listeners_[id] = fd;
+}
+
+void NetworkServer::Stop(){
+    stopping_ = true;
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t res = write(wake_fd_, &one, sizeof(one));
+}
+
+void NetworkServer::Run(){
+    std::vector<epoll_event> events(256);
+    while(!stopping_){
+        int count = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+        if(count < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            throw SystemError("epoll_wait failed"s);
+        }
+
+        for(int i = 0; i < count; ++i){
+            uint64_t id = events[i].data.u64;
+            if(id == WAKE_ID){
+                uint64_t value;
+                [[maybe_unused]] ssize_t res = read(wake_fd_, &value, sizeof(value));
+                DrainCompletions();
+                continue;
+            }
+            if(auto listener = listeners_.find(id); listener != listeners_.end()){
+                AcceptConnections(listener->second);
+                continue;
+            }
+
+            auto it = connections_.find(id);
+            if(it == connections_.end()){
+                continue;
+            }
+            Connection& connection = *it->second;
+            if(events[i].events & (EPOLLHUP | EPOLLERR)){
+                CloseConnection(id);
+                continue;
+            }
+            if(events[i].events & EPOLLIN){
+                HandleReadable(id, connection);
+            }
+            if(events[i].events & EPOLLOUT){
+                if(!FlushOutput(connection)){
+                    CloseConnection(id);
+                    continue;
+                }
+            }
+            UpdateConnection(id, connection);
+        }
+    }
+}
+
+void NetworkServer::AcceptConnections(int listen_fd){
+    while(true){
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            return;
+        }
+
+        uint64_t id = next_id_++;
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+
+        epoll_event event{};
+        event.events = connection->events;
+        event.data.u64 = id;
+        if(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0){
+            close(fd);
+            continue;
+        }
+        connections_[id] = std::move(connection);
+    }
+}
+
+void NetworkServer::HandleReadable(uint64_t id, Connection& connection){
+    char chunk[READ_CHUNK_SIZE];
+    while(!connection.read_closed && CanRead(connection)){
+        ssize_t res = recv(connection.fd, chunk, sizeof(chunk), 0);
+        if(res > 0){
+            connection.input.append(chunk, static_cast<size_t>(res));
+            if(static_cast<size_t>(res) < sizeof(chunk)){
+                break;
+            }
+            continue;
+        }
+        if(res < 0 && errno == EINTR){
+            continue;
+        }
+        if(res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            break;
+        }
+        connection.read_closed = true;
+    }
+    DispatchLines(id, connection);
+}
+
+bool NetworkServer::CanRead(const Connection& connection) const{
+    return CanAcceptMore(connection) && connection.input.size() < settings_.max_input_buffered;
+}
+
+bool NetworkServer::CanAcceptMore(const Connection& connection) const{
+    return connection.next_sequence - connection.next_to_send < settings_.max_requests_in_flight
+           && connection.output.size() - connection.output_offset < settings_.output_high_watermark;
+}
+
+void NetworkServer::DispatchLines(uint64_t id, Connection& connection){
+    size_t line_begin = 0;
+    size_t pos;
+    while(CanAcceptMore(connection) && !connection.running_write){
+        if(connection.held_write){
+            if(connection.running > 0){
+                break;
+            }
+            PendingRequest request = std::move(*connection.held_write);
+            connection.held_write.reset();
+            Submit(id, connection, std::move(request));
+            continue;
+        }
+        if((pos = connection.input.find('\n', line_begin)) == std::string::npos){
+            // после закрытия записи клиентом перевода строки уже не будет, и остаток - последний запрос, как в getline
+            size_t rest = connection.input.size() - line_begin;
+            if(!connection.read_closed || rest == 0 || rest > settings_.max_line_length){
+                break;
+            }
+            pos = connection.input.size();
+        }
+        std::string line = connection.input.substr(line_begin, pos - line_begin);
+        line_begin = std::min(pos + 1, connection.input.size());
+        if(line.find_first_not_of(" \t\r") == std::string::npos){
+            continue;
+        }
+
+        PendingRequest request{query_server_.ParseLine(line), std::nullopt};
+        if(request.parsed.deadline){
+            request.deadline = RequestScheduler::Clock::now() + *request.parsed.deadline;
+        }
+        if(request.parsed.cost == CostClass::WRITE && connection.running > 0){
+            connection.held_write = std::move(request);
+            continue;
+        }
+        Submit(id, connection, std::move(request));
+    }
+    connection.input.erase(0, line_begin);
+
+    // ограничение длины относится только к недописанной строке: целые строки ждут своей очереди в буфере
+    size_t last_newline = connection.input.rfind('\n');
+    size_t unfinished = last_newline == std::string::npos ? connection.input.size() : connection.input.size() - last_newline - 1;
+    if(unfinished > settings_.max_line_length){
+        connection.read_closed = true;
+        connection.input.clear();
+    }
+}
+
+void NetworkServer::Submit(uint64_t id, Connection& connection, PendingRequest request){
+    uint64_t sequence = connection.next_sequence++;
+    ++connection.running;
+    if(request.parsed.cost == CostClass::WRITE){
+        connection.running_write = sequence;
+    }
+    scheduler_->Submit(request.parsed.cost, request.deadline,
+                       [this, id, sequence, parsed = std::move(request.parsed)](bool deadline_expired){
+        Complete(id, sequence, deadline_expired ? query_server_.AnswerExpired(parsed)
+                                                : query_server_.Answer(parsed));
+    });
+}
+
+void NetworkServer::Complete(uint64_t connection_id, uint64_t sequence, std::string response){
+    bool was_empty;
+    {
+        std::lock_guard lock(completions_mutex_);
+        was_empty = completions_.empty();
+        completions_.push_back({connection_id, sequence, std::move(response)});
+    }
+    if(was_empty){
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t res = write(wake_fd_, &one, sizeof(one));
+    }
+}
+
+void NetworkServer::DrainCompletions(){
+    std::vector<Completion> completions;
+    {
+        std::lock_guard lock(completions_mutex_);
+        completions.swap(completions_);
+    }
+
+    std::vector<uint64_t> touched;
+    for(Completion& completion : completions){
+        auto it = connections_.find(completion.connection_id);
+        if(it == connections_.end()){
+            continue;
+        }
+        Connection& connection = *it->second;
+        --connection.running;
+        if(connection.running_write == completion.sequence){
+            connection.running_write.reset();
+        }
+        connection.ready[completion.sequence] = std::move(completion.response);
+        touched.push_back(completion.connection_id);
+    }
+
+    for(uint64_t id : touched){
+        auto it = connections_.find(id);
+        if(it == connections_.end()){
+            continue;
+        }
+        Connection& connection = *it->second;
+        // ответы уходят клиенту строго в порядке поступления запросов
+        for(auto ready = connection.ready.begin();
+            ready != connection.ready.end() && ready->first == connection.next_to_send;
+            ready = connection.ready.erase(ready)){
+            connection.output += ready->second;
+            ++connection.next_to_send;
+        }
+        if(!FlushOutput(connection)){
+            CloseConnection(id);
+            continue;
+        }
+        DispatchLines(id, connection);
+        UpdateConnection(id, connection);
+    }
+}
+
+bool NetworkServer::FlushOutput(Connection& connection){
+    while(connection.output_offset < connection.output.size()){
+        ssize_t res = send(connection.fd, connection.output.data() + connection.output_offset,
+                           connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if(res < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK){
+                break;
+            }
+            return false;
+        }
+        connection.output_offset += static_cast<size_t>(res);
+    }
+    if(connection.output_offset == connection.output.size()){
+        connection.output.clear();
+        connection.output_offset = 0;
+    }else if(connection.output_offset > connection.output.size() / 2){
+        connection.output.erase(0, connection.output_offset);
+        connection.output_offset = 0;
+    }
+    return true;
+}
+
+void NetworkServer::UpdateConnection(uint64_t id, Connection& connection){
+    bool has_output = connection.output_offset < connection.output.size();
+    if(connection.read_closed && !has_output && connection.next_sequence == connection.next_to_send){
+        CloseConnection(id);
+        return;
+    }
+
+    uint32_t events = 0;
+    if(!connection.read_closed && CanRead(connection)){
+        events |= EPOLLIN;
+    }
+    if(has_output){
+        events |= EPOLLOUT;
+    }
+    if(events != connection.events){
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = id;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.events = events;
+    }
+}
+
+void NetworkServer::CloseConnection(uint64_t id){
+    auto it = connections_.find(id);
+    if(it == connections_.end()){
+        return;
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second->fd, nullptr);
+    close(it->second->fd);
+    connections_.erase(it);
+}
+
+}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "query_server.h"
+#include "request_scheduler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace transport_catalogue{
+namespace server{
+
+struct NetworkServerSettings{
+    SchedulerSettings scheduler;
+    size_t max_requests_in_flight = 64;
+    size_t output_high_watermark = 1 << 20;
+    size_t max_line_length = 1 << 20;
+    // сверх этого объёма непрочитанных строк соединение не читается, пока запросы не разберутся
+    size_t max_input_buffered = 4 << 20;
+};
+
+class NetworkServer{
+
+public:
+
+    NetworkServer(const QueryServer& query_server, NetworkServerSettings settings);
+    ~NetworkServer();
+
+    NetworkServer(const NetworkServer&) = delete;
+    NetworkServer& operator=(const NetworkServer&) = delete;
+
+    uint16_t ListenTcp(uint16_t port);
+    void ListenUnix(const std::string& socket_path);
+    void Run();
+    void Stop();
+
+private:
+    struct PendingRequest{
+        ParsedRequest parsed;
+        std::optional<RequestScheduler::Clock::time_point> deadline;
+    };
+
+    struct Connection{
+        int fd = -1;
+        std::string input;
+        std::string output;
+        size_t output_offset = 0;
+        uint64_t next_sequence = 0;
+        uint64_t next_to_send = 0;
+        std::map<uint64_t, std::string> ready;
+        bool read_closed = false;
+        uint32_t events = 0;
+        // запросы соединения видят каталог в порядке отправки: изменение ждёт завершения всех запросов до него,
+        // а следующие за ним запросы не отправляются, пока оно не применено
+        size_t running = 0;
+        std::optional<uint64_t> running_write;
+        std::optional<PendingRequest> held_write;
+    };
+
+    struct Completion{
+        uint64_t connection_id;
+        uint64_t sequence;
+        std::string response;
+    };
+
+    void AddListenSocket(int fd);
+    void AcceptConnections(int listen_fd);
+    void HandleReadable(uint64_t id, Connection& connection);
+    void DispatchLines(uint64_t id, Connection& connection);
+    void Submit(uint64_t id, Connection& connection, PendingRequest request);
+    void Complete(uint64_t connection_id, uint64_t sequence, std::string response);
+    void DrainCompletions();
+    bool FlushOutput(Connection& connection);
+    bool CanAcceptMore(const Connection& connection) const;
+    bool CanRead(const Connection& connection) const;
+    void UpdateConnection(uint64_t id, Connection& connection);
+    void CloseConnection(uint64_t id);
+
+    const QueryServer& query_server_;
+    NetworkServerSettings settings_;
+
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    uint64_t next_id_ = 1;
+    std::unordered_map<uint64_t, int> listeners_;
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections_;
+    std::string unix_socket_path_;
+    std::atomic<bool> stopping_ = false;
+
+    std::mutex completions_mutex_;
+    std::vector<Completion> completions_;
+
+    std::optional<RequestScheduler> scheduler_;
+};
+
+}
+}
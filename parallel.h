@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+    namespace detail {
+        inline thread_local size_t thread_limit = 0;
+    }
+
+    // ограничивает число потоков параллельных операций, запущенных из текущего потока, на время своей жизни;
+    // 0 - все аппаратные потоки. потоки сервера ставят 1, чтобы один запрос не занимал все ядра в обход планировщика
+    class ScopedThreadLimit {
+    public:
+        explicit ScopedThreadLimit(size_t limit): previous_(detail::thread_limit) {
+            detail::thread_limit = limit;
+        }
+
+        ~ScopedThreadLimit() {
+            detail::thread_limit = previous_;
+        }
+
+        ScopedThreadLimit(const ScopedThreadLimit&) = delete;
+        ScopedThreadLimit& operator=(const ScopedThreadLimit&) = delete;
+
+    private:
+        size_t previous_;
+    };
+
+    inline size_t ThreadCount() {
+        size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+        return detail::thread_limit == 0 ? hardware : std::min(hardware, detail::thread_limit);
+    }
+
+    // задачи [0, count) разбираются потоками по одной, поэтому задачи разной стоимости распределяются сами.
+    // вложенные параллельные операции внутри f выполняются в одном потоке. после ошибки новые задачи не начинаются, исключение пробрасывается после завершения всех потоков
+    template <typename F>
+    void ForEachIndex(size_t count, F&& f) {
+        size_t threads = std::min(ThreadCount(), count);
+        std::atomic<size_t> next = 0;
+        std::vector<std::exception_ptr> errors(std::max<size_t>(threads, 1));
+        auto run = [&](size_t worker) {
+            ScopedThreadLimit limit(1);
+            try {
+                for (size_t index = next++; index < count; index = next++) {
+                    f(index);
+                }
+            } catch (...) {
+                errors[worker] = std::current_exception();
+                next = count;
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t worker = 1; worker < threads; ++worker) {
+            workers.emplace_back(run, worker);
+        }
+        run(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        for (const std::exception_ptr& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+}
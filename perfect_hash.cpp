@@ -0,0 +1,129 @@
+#include "perfect_hash.h"
+#include "flat_hash_map.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace perfect_hash {
+
+    namespace {
+        // меньше ключей на корзину - быстрее построение, больше - компактнее таблица сдвигов
+        constexpr size_t KEYS_PER_BUCKET = 3;
+        constexpr uint32_t MAX_PILOT = 1u << 20;
+        constexpr uint64_t MAX_SEEDS = 16;
+        constexpr uint64_t SEED_STEP = 0x9e3779b97f4a7c15ull;
+
+        // отображает 64-битный хеш на [0, range) умножением вместо деления
+        uint64_t Reduce(uint64_t hash, uint64_t range) {
+#ifdef __SIZEOF_INT128__
+            return static_cast<uint64_t>((static_cast<__uint128_t>(hash) * range) >> 64);
+#else
+            return hash % range;
+#endif
+        }
+
+        uint64_t HashKey(std::string_view key) {
+            return flat_hash::HashBytes(key.data(), key.size());
+        }
+    }
+
+    MinimalPerfectHash::MinimalPerfectHash(const std::vector<std::string_view>& keys)
+            : slot_count_(keys.size()) {
+        if (keys.empty()) {
+            return;
+        }
+        std::vector<uint64_t> base_hashes;
+        base_hashes.reserve(keys.size());
+        for (std::string_view key : keys) {
+            base_hashes.push_back(HashKey(key));
+        }
+
+        std::vector<uint64_t> key_hashes(keys.size());
+        for (uint64_t attempt = 1; attempt <= MAX_SEEDS; ++attempt) {
+            seed_ = attempt * SEED_STEP;
+            for (size_t i = 0; i < keys.size(); ++i) {
+                key_hashes[i] = flat_hash::MixBits(base_hashes[i] ^ seed_);
+            }
+            if (TryBuild(key_hashes)) {
+                return;
+            }
+        }
+        // с любым зерном не разводятся только ключи с одинаковым 64-битным хешем
+        throw std::invalid_argument("Perfect hash keys are not distinct");
+    }
+
+    size_t MinimalPerfectHash::operator()(std::string_view key) const {
+        uint64_t hash = flat_hash::MixBits(HashKey(key) ^ seed_);
+        return Slot(hash, pilots_[Bucket(hash)]);
+    }
+
+    size_t MinimalPerfectHash::Bucket(uint64_t hash) const {
+        return Reduce(hash, pilots_.size());
+    }
+
+    size_t MinimalPerfectHash::Slot(uint64_t hash, uint32_t pilot) const {
+        // корзина выбирается по старшим битам, поэтому слот считается от хеша, перемешанного со сдвигом
+        return Reduce(flat_hash::MixBits(hash ^ (pilot * SEED_STEP)), slot_count_);
+    }
+
+    // корзины размещаются от больших к малым, пока свободных слотов много
+    bool MinimalPerfectHash::TryBuild(const std::vector<uint64_t>& key_hashes) {
+        size_t bucket_count = (key_hashes.size() + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET;
+        pilots_.assign(bucket_count, 0);
+
+        std::vector<size_t> bucket_begin(bucket_count + 1, 0);
+        for (uint64_t hash : key_hashes) {
+            ++bucket_begin[Bucket(hash) + 1];
+        }
+        for (size_t bucket = 0; bucket < bucket_count; ++bucket) {
+            bucket_begin[bucket + 1] += bucket_begin[bucket];
+        }
+        std::vector<uint64_t> bucketed(key_hashes.size());
+        std::vector<size_t> cursor(bucket_begin.begin(), bucket_begin.end() - 1);
+        for (uint64_t hash : key_hashes) {
+            bucketed[cursor[Bucket(hash)]++] = hash;
+        }
+
+        auto bucket_size = [&bucket_begin](size_t bucket) {
+            return bucket_begin[bucket + 1] - bucket_begin[bucket];
+        };
+        std::vector<size_t> order(bucket_count);
+        for (size_t bucket = 0; bucket < bucket_count; ++bucket) {
+            order[bucket] = bucket;
+        }
+        std::stable_sort(order.begin(), order.end(), [&bucket_size](size_t lhs, size_t rhs) {
+            return bucket_size(lhs) > bucket_size(rhs);
+        });
+
+        std::vector<bool> taken(slot_count_, false);
+        std::vector<size_t> slots;
+        for (size_t bucket : order) {
+            if (bucket_size(bucket) == 0) {
+                break;
+            }
+            bool placed = false;
+            for (uint32_t pilot = 0; pilot < MAX_PILOT && !placed; ++pilot) {
+                slots.clear();
+                placed = true;
+                for (size_t i = bucket_begin[bucket]; i < bucket_begin[bucket + 1]; ++i) {
+                    size_t slot = Slot(bucketed[i], pilot);
+                    if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                        placed = false;
+                        break;
+                    }
+                    slots.push_back(slot);
+                }
+                if (placed) {
+                    for (size_t slot : slots) {
+                        taken[slot] = true;
+                    }
+                    pilots_[bucket] = pilot;
+                }
+            }
+            if (!placed) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
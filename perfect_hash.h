@@ -0,0 +1,46 @@
+#pragma once
+
+#include "memory_accounting.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace perfect_hash {
+
+    // минимальная совершенная хеш-функция по схеме CHD (hash, displace, compress):
+    // ключи делятся на корзины, и для каждой корзины подбирается сдвиг, разводящий её ключи по свободным слотам.
+    // n ключей занимают ровно n слотов, вычисление стоит одного хеша строки и одного чтения сдвига.
+    // для ключа не из множества возвращается произвольный слот, поэтому вызывающий сверяет ключ сам.
+    // всё состояние - числа фиксированной ширины, его можно сохранить в двоичный снимок как есть
+    class MinimalPerfectHash {
+    public:
+        MinimalPerfectHash() = default;
+        // ключи должны быть различными
+        explicit MinimalPerfectHash(const std::vector<std::string_view>& keys);
+
+        // слот в диапазоне [0, size()); для пустого множества вызывать нельзя
+        size_t operator()(std::string_view key) const;
+
+        size_t size() const {
+            return slot_count_;
+        }
+
+        bool empty() const {
+            return slot_count_ == 0;
+        }
+
+    private:
+        using PilotList = std::vector<uint32_t,
+                memory_accounting::Allocator<uint32_t, memory_accounting::Subsystem::FROZEN_NAME_INDEX>>;
+
+        bool TryBuild(const std::vector<uint64_t>& key_hashes);
+        size_t Bucket(uint64_t hash) const;
+        size_t Slot(uint64_t hash, uint32_t pilot) const;
+
+        uint64_t seed_ = 0;
+        uint64_t slot_count_ = 0;
+        PilotList pilots_;
+    };
+}
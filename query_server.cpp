@@ -0,0 +1,186 @@
+#include "query_server.h"
+#include "instrumentation.h"
+
+#include <sstream>
+
+using namespace std::string_literals;
+
+namespace transport_catalogue{
+namespace server{
+
+namespace {
+
+std::string PrintResponseLine(const json::Node& response){
+    std::ostringstream out;
+    json::PrintNode(response, out);
+    out << '\n';
+    return out.str();
+}
+
+void SetRequestId(const std::shared_ptr<const json::Node>& request, json::Dict& response){
+    if(request && request->IsMap() && request->AsMap().count("id") && request->AsMap().at("id").IsInt()){
+        response["request_id"] = request->AsMap().at("id").AsInt();
+    }
+}
+
+std::string PrintErrorLine(const std::shared_ptr<const json::Node>& request, const std::string& error){
+    json::Dict error_response;
+    error_response["error_message"] = error;
+    SetRequestId(request, error_response);
+    return PrintResponseLine(error_response);
+}
+
+// кэшируются только карта и сводки по сети: ответ о маршруте собирается быстрее, чем ждёт общую блокировку кэша
+std::optional<std::string> CacheKey(const schema::StatQuery& query){
+    if(std::holds_alternative<schema::MapQuery>(query) || std::holds_alternative<schema::AnalyticsQuery>(query)){
+        return schema::QueryKey(query);
+    }
+    return std::nullopt;
+}
+
+bool HasType(const json::Dict& request, const std::string& expected){
+    auto type = request.find("type"s);
+    return type != request.end() && type->second.IsString() && type->second.AsString() == expected;
+}
+
+}
+
+QueryServer::QueryServer(VersionedCatalogue& catalogue, const MapRenderer& map_renderer)
+        : catalogue_(catalogue), map_renderer_(map_renderer){}
+
+ParsedRequest QueryServer::ParseLine(const std::string& line) const{
+    ParsedRequest parsed;
+    try{
+        std::istringstream strm(line);
+        parsed.request = std::make_shared<const json::Node>(json::Load(strm).GetRoot());
+        const json::Dict& request = parsed.request->AsMap();
+        if(HasType(request, "Update"s)){
+            std::vector<schema::BaseRecord> records;
+            for(const json::Node& record : request.at("base_requests"s).AsArray()){
+                if(auto decoded = schema::DecodeBaseRecord(record.AsMap())){
+                    records.push_back(std::move(*decoded));
+                }
+            }
+            parsed.update = std::move(records);
+            parsed.cost = CostClass::WRITE;
+        }else if(HasType(request, "Delta"s)){
+            std::vector<schema::DeltaRecord> records;
+            for(const json::Node& record : request.at("changes"s).AsArray()){
+                records.push_back(schema::DecodeDeltaRecord(record.AsMap()));
+            }
+            parsed.delta = std::move(records);
+            parsed.cost = CostClass::WRITE;
+        }else{
+            parsed.query = schema::DecodeStatQuery(request);
+        }
+        if(parsed.query && (std::holds_alternative<schema::MapQuery>(*parsed.query)
+                            || std::holds_alternative<schema::AnalyticsQuery>(*parsed.query))){
+            parsed.cost = CostClass::HEAVY;
+        }
+        if(auto deadline = request.find("deadline_ms"s); deadline != request.end()){
+            parsed.deadline = std::chrono::milliseconds(deadline->second.AsInt());
+        }
+    }catch(const std::exception& e){
+        parsed.error = e.what();
+    }
+    return parsed;
+}
+
+std::string QueryServer::Answer(const ParsedRequest& parsed) const{
+    if(!parsed.error.empty()){
+        return PrintErrorLine(parsed.request, parsed.error);
+    }
+    if(parsed.update || parsed.delta){
+        return ApplyUpdate(parsed);
+    }
+    if(!parsed.query){
+        return PrintErrorLine(parsed.request, "unknown request type"s);
+    }
+    json::Array response;
+    try{
+        // снимок удерживается до конца ответа, даже если параллельно публикуется новая версия
+        const std::shared_ptr<const TransportCatalogue> snapshot = catalogue_.Current();
+        const int id = std::visit([](const auto& query){ return query.id; }, *parsed.query);
+        if(const std::shared_ptr<const ResponseFragments> fragments = GetFragments(snapshot)){
+            TC_SCOPED_TIMER(QUERY_FRAGMENT);
+            if(auto fragment = fragments->Find(*parsed.query)){
+                std::string line;
+                fragment->Append(id, line);
+                line += '\n';
+                return line;
+            }
+        }
+        std::optional<std::string> cache_key = CacheKey(*parsed.query);
+        if(cache_key){
+            if(const std::shared_ptr<const json::Node> cached = cache_.Find(snapshot->GetVersion(), *cache_key)){
+                json::Dict answer = cached->AsMap();
+                answer["request_id"] = id;
+                return PrintResponseLine(answer);
+            }
+        }
+        input::JSONReader(*snapshot).AnswerQuery(map_renderer_, *parsed.query, response);
+        if(cache_key){
+            json::Dict cached = response.front().AsMap();
+            cached.erase("request_id"s);
+            cache_.Insert(snapshot->GetVersion(), std::move(*cache_key), std::move(cached));
+        }
+    }catch(const std::exception& e){
+        return PrintErrorLine(parsed.request, e.what());
+    }
+    return PrintResponseLine(response.front());
+}
+
+// снимок старше последних фрагментов отвечает обычным путём, чтобы не отбрасывать фрагменты новой версии
+std::shared_ptr<const ResponseFragments> QueryServer::GetFragments(const std::shared_ptr<const TransportCatalogue>& snapshot) const{
+    if(!ResponseFragments::IsEnabled()){
+        return nullptr;
+    }
+    std::lock_guard lock(fragments_mutex_);
+    if(!fragments_ || fragments_->GetVersion() < snapshot->GetVersion()){
+        fragments_ = std::make_shared<const ResponseFragments>(snapshot);
+    }
+    return fragments_->GetVersion() == snapshot->GetVersion() ? fragments_ : nullptr;
+}
+
+// пакет применяется к копии целиком: при ошибке новая версия не публикуется
+std::string QueryServer::ApplyUpdate(const ParsedRequest& parsed) const{
+    std::shared_ptr<const TransportCatalogue> version;
+    try{
+        version = catalogue_.Update([&parsed](TransportCatalogue& catalogue){
+            input::JSONReader reader(catalogue);
+            if(parsed.update){
+                reader.CreateDb(*parsed.update);
+            }else{
+                reader.ApplyDelta(*parsed.delta);
+            }
+        });
+    }catch(const std::exception& e){
+        return PrintErrorLine(parsed.request, e.what());
+    }
+    json::Dict response;
+    response["version"] = static_cast<int>(version->GetVersion());
+    SetRequestId(parsed.request, response);
+    return PrintResponseLine(response);
+}
+
+std::string QueryServer::AnswerExpired(const ParsedRequest& parsed) const{
+    return PrintErrorLine(parsed.request, "deadline exceeded"s);
+}
+
+std::string QueryServer::AnswerLine(const std::string& line) const{
+    return Answer(ParseLine(line));
+}
+
+void QueryServer::ServeStream(std::istream& input, std::ostream& output) const{
+    std::string line;
+    while(std::getline(input, line)){
+        if(line.find_first_not_of(" \t\r") == std::string::npos){
+            continue;
+        }
+        output << AnswerLine(line);
+        output.flush();
+    }
+}
+
+}
+}
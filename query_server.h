@@ -0,0 +1,57 @@
+#pragma once
+
+#include "json_reader.h"
+#include "map_renderer.h"
+#include "request_scheduler.h"
+#include "request_schema.h"
+#include "response_cache.h"
+#include "response_fragments.h"
+#include "versioned_catalogue.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace transport_catalogue{
+namespace server{
+
+struct ParsedRequest{
+    std::shared_ptr<const json::Node> request;
+    std::optional<schema::StatQuery> query;
+    std::optional<std::vector<schema::BaseRecord>> update;
+    std::optional<std::vector<schema::DeltaRecord>> delta;
+    std::string error;
+    CostClass cost = CostClass::LIGHT;
+    std::optional<std::chrono::milliseconds> deadline;
+};
+
+class QueryServer{
+
+public:
+
+    QueryServer(VersionedCatalogue& catalogue, const MapRenderer& map_renderer);
+
+    ParsedRequest ParseLine(const std::string& line) const;
+    std::string Answer(const ParsedRequest& parsed) const;
+    std::string AnswerExpired(const ParsedRequest& parsed) const;
+    std::string AnswerLine(const std::string& line) const;
+    void ServeStream(std::istream& input, std::ostream& output) const;
+
+private:
+    std::string ApplyUpdate(const ParsedRequest& parsed) const;
+    std::shared_ptr<const ResponseFragments> GetFragments(const std::shared_ptr<const TransportCatalogue>& snapshot) const;
+
+    VersionedCatalogue& catalogue_;
+    const MapRenderer& map_renderer_;
+    mutable ResponseCache cache_;
+    // фрагменты последней версии каталога; с публикацией новой версии заводятся заново
+    mutable std::mutex fragments_mutex_;
+    mutable std::shared_ptr<const ResponseFragments> fragments_;
+};
+
+}
+}
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "catalogue_service.h"
+#include "compression.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+std::atomic<size_t> allocations = 0;
+
+}
+
+// счётчик выделений памяти для отчёта; выделения до main тоже учитываются, но в отчёт не попадают
+void* operator new(size_t size){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* result = std::malloc(size == 0 ? 1 : size)){
+        return result;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size){
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept{
+    std::free(ptr);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ReplaySettings{
+    std::string base_path;
+    std::string log_path;
+    std::string report_path;
+    size_t repeat = 1;
+    size_t warmup = 1;
+};
+
+struct TypeSamples{
+    std::vector<double> latencies_us;
+    size_t allocations = 0;
+};
+
+const std::vector<std::pair<std::string, double>> PERCENTILES{
+        {"p50_us"s, 0.5}, {"p90_us"s, 0.9}, {"p99_us"s, 0.99}, {"p999_us"s, 0.999}};
+
+void PrintUsage(std::ostream& out){
+    out << "Usage:\n"
+           "  replay --base <base.json[.gz]> --log <requests.jsonl> [--repeat <count>] [--warmup <count>] [--report <report.json>]\n"
+           "  replay --compare <baseline.json> <candidate.json> [--threshold <fraction>]\n";
+}
+
+std::vector<std::string> ReadLog(const std::string& path){
+    std::ifstream file(path, std::ios::binary);
+    if(!file){
+        throw std::runtime_error("Failed to open "s + path);
+    }
+    compression::InputStream input(file);
+    std::vector<std::string> lines;
+    for(std::string line; std::getline(input, line);){
+        if(line.find_first_not_of(" \t\r") != std::string::npos){
+            lines.push_back(std::move(line));
+        }
+    }
+    if(lines.empty()){
+        throw std::runtime_error("No requests in "s + path);
+    }
+    return lines;
+}
+
+std::string RequestType(const transport_catalogue::server::ParsedRequest& parsed){
+    if(!parsed.query){
+        return "invalid"s;
+    }
+    return std::visit([](const auto& query){
+        return std::string(transport_catalogue::schema::Schema<std::decay_t<decltype(query)>>::name);
+    }, *parsed.query);
+}
+
+// ближайший ранг: наименьшая задержка, не меньше которой доля p всех замеров
+double Percentile(const std::vector<double>& sorted, double p){
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+json::Dict Replay(const ReplaySettings& settings){
+    std::ifstream base_file(settings.base_path, std::ios::binary);
+    if(!base_file){
+        throw std::runtime_error("Failed to open "s + settings.base_path);
+    }
+    const transport_catalogue::CatalogueService service(base_file);
+    const transport_catalogue::server::QueryServer& query_server = service.GetQueryServer();
+    const std::vector<std::string> lines = ReadLog(settings.log_path);
+
+    for(size_t pass = 0; pass < settings.warmup; ++pass){
+        for(const std::string& line : lines){
+            query_server.AnswerLine(line);
+        }
+    }
+
+    std::map<std::string, TypeSamples> samples;
+    std::chrono::duration<double> total{0};
+    for(size_t pass = 0; pass < settings.repeat; ++pass){
+        for(const std::string& line : lines){
+            size_t allocations_before = allocations.load(std::memory_order_relaxed);
+            auto start = Clock::now();
+            transport_catalogue::server::ParsedRequest parsed = query_server.ParseLine(line);
+            std::string response = query_server.Answer(parsed);
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            size_t allocations_after = allocations.load(std::memory_order_relaxed);
+
+            TypeSamples& type_samples = samples[RequestType(parsed)];
+            type_samples.latencies_us.push_back(elapsed.count() * 1e6);
+            type_samples.allocations += allocations_after - allocations_before;
+            total += elapsed;
+        }
+    }
+
+    json::Dict types;
+    size_t requests = 0;
+    for(auto& [type, type_samples] : samples){
+        std::sort(type_samples.latencies_us.begin(), type_samples.latencies_us.end());
+        json::Dict metrics;
+        size_t count = type_samples.latencies_us.size();
+        metrics["count"s] = static_cast<int>(count);
+        for(const auto& [name, p] : PERCENTILES){
+            metrics[name] = Percentile(type_samples.latencies_us, p);
+        }
+        metrics["allocations_per_request"s] = static_cast<double>(type_samples.allocations) / static_cast<double>(count);
+        types[type] = metrics;
+        requests += count;
+    }
+
+    json::Dict report;
+    report["requests"s] = static_cast<int>(requests);
+    report["elapsed_s"s] = total.count();
+    report["throughput"s] = static_cast<double>(requests) / total.count();
+    report["types"s] = types;
+    return report;
+}
+
+void PrintReport(const json::Dict& report, std::ostream& out){
+    out << std::left << std::setw(10) << "type"s << std::right << std::setw(10) << "count"s;
+    for(const auto& [name, p] : PERCENTILES){
+        out << std::setw(12) << name;
+    }
+    out << std::setw(14) << "allocs/req"s << '\n' << std::fixed << std::setprecision(1);
+    for(const auto& [type, metrics] : report.at("types"s).AsMap()){
+        const json::Dict& values = metrics.AsMap();
+        out << std::left << std::setw(10) << type << std::right << std::setw(10) << values.at("count"s).AsInt();
+        for(const auto& [name, p] : PERCENTILES){
+            out << std::setw(12) << values.at(name).AsDouble();
+        }
+        out << std::setw(14) << values.at("allocations_per_request"s).AsDouble() << '\n';
+    }
+    out << "requests: "s << report.at("requests"s).AsInt()
+        << ", throughput: "s << std::setprecision(0) << report.at("throughput"s).AsDouble() << " req/s"s << std::endl;
+}
+
+json::Dict ReadReport(const std::string& path){
+    std::ifstream file(path);
+    if(!file){
+        throw std::runtime_error("Failed to open "s + path);
+    }
+    return json::Load(file).GetRoot().AsMap();
+}
+
+// регрессией считается рост задержки или числа выделений либо падение пропускной способности больше чем на threshold
+bool Compare(const std::string& baseline_path, const std::string& candidate_path, double threshold, std::ostream& out){
+    const json::Dict baseline = ReadReport(baseline_path);
+    const json::Dict candidate = ReadReport(candidate_path);
+    bool regression = false;
+
+    auto report_metric = [&](const std::string& name, double before, double after, bool higher_is_better){
+        double change = before == 0 ? 0 : (after - before) / before;
+        bool worse = higher_is_better ? change < -threshold : change > threshold;
+        regression = regression || worse;
+        out << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(14) << before << std::setw(14) << after
+            << std::setw(10) << std::showpos << change * 100 << '%' << std::noshowpos
+            << (worse ? "  REGRESSION"s : ""s) << '\n';
+    };
+
+    report_metric("throughput"s, baseline.at("throughput"s).AsDouble(), candidate.at("throughput"s).AsDouble(), true);
+    const json::Dict& candidate_types = candidate.at("types"s).AsMap();
+    for(const auto& [type, metrics] : baseline.at("types"s).AsMap()){
+        auto it = candidate_types.find(type);
+        if(it == candidate_types.end()){
+            out << type << ": missing in candidate\n"s;
+            continue;
+        }
+        const json::Dict& before = metrics.AsMap();
+        const json::Dict& after = it->second.AsMap();
+        // хвостовой перцентиль без хотя бы одного замера за его границей — шум, а не сигнал
+        int count = std::min(before.at("count"s).AsInt(), after.at("count"s).AsInt());
+        for(const auto& [name, p] : PERCENTILES){
+            if(count * (1 - p) >= 1){
+                report_metric(type + ' ' + name, before.at(name).AsDouble(), after.at(name).AsDouble(), false);
+            }
+        }
+        report_metric(type + " allocations_per_request"s, before.at("allocations_per_request"s).AsDouble(),
+                      after.at("allocations_per_request"s).AsDouble(), false);
+    }
+    out.flush();
+    return regression;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if(argc >= 4 && argv[1] == "--compare"s){
+        double threshold = 0.1;
+        if(argc == 6 && argv[4] == "--threshold"s){
+            threshold = std::stod(argv[5]);
+        }else if(argc != 4){
+            PrintUsage(std::cerr);
+            return 1;
+        }
+        return Compare(argv[2], argv[3], threshold, std::cout) ? 3 : 0;
+    }
+
+    ReplaySettings settings;
+    for(int i = 1; i + 1 < argc; i += 2){
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if(arg == "--base"s){
+            settings.base_path = value;
+        }else if(arg == "--log"s){
+            settings.log_path = value;
+        }else if(arg == "--report"s){
+            settings.report_path = value;
+        }else if(arg == "--repeat"s){
+            settings.repeat = std::max(1, std::stoi(value));
+        }else if(arg == "--warmup"s){
+            settings.warmup = std::max(0, std::stoi(value));
+        }else{
+            PrintUsage(std::cerr);
+            return 1;
+        }
+    }
+    if(argc % 2 == 0 || settings.base_path.empty() || settings.log_path.empty()){
+        PrintUsage(std::cerr);
+        return 1;
+    }
+
+    const json::Dict report = Replay(settings);
+    PrintReport(report, std::cout);
+    if(!settings.report_path.empty()){
+        std::ofstream file(settings.report_path);
+        json::Print(json::Document(report), file);
+        file << '\n';
+    }
+}
@@ -2,9 +2,9 @@
 
 std::set<Bus> GetBusesOnRoute(const transport_catalogue::TransportCatalogue& catalogue){
     std::set<Bus> buses;
-    for(const Bus& bus : catalogue.GetAllBuses()){
-        if(!bus.stops.empty()){
-            buses.insert(bus);
+    for(const auto& bus : catalogue.GetAllBuses()){
+        if(bus && !bus->stops.empty()){
+            buses.insert(*bus);
         }
     }
     return buses;
@@ -0,0 +1,96 @@
+#include "request_scheduler.h"
+#include "parallel.h"
+
+#include <algorithm>
+
+namespace transport_catalogue{
+namespace server{
+
+RequestScheduler::RequestScheduler(SchedulerSettings settings){
+    int workers = std::max(1, settings.workers);
+    // хотя бы один поток всегда остаётся свободным для лёгких запросов, если потоков больше одного
+    max_heavy_running_ = std::clamp(settings.max_heavy_running, 1, std::max(1, workers - 1));
+    for(int i = 0; i < workers; ++i){
+        workers_.emplace_back([this]{ WorkerLoop(); });
+    }
+}
+
+RequestScheduler::~RequestScheduler(){
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for(std::thread& worker : workers_){
+        worker.join();
+    }
+}
+
+void RequestScheduler::Submit(CostClass cost, std::optional<Clock::time_point> deadline, Job job){
+    {
+        std::lock_guard lock(mutex_);
+        if(cost == CostClass::HEAVY){
+            heavy_tasks_.push_back({deadline, std::move(job)});
+        }else if(cost == CostClass::WRITE){
+            write_tasks_.push_back({deadline, std::move(job)});
+        }else{
+            light_tasks_.push_back({deadline, std::move(job)});
+        }
+    }
+    cv_.notify_one();
+}
+
+void RequestScheduler::WorkerLoop(){
+    // число одновременно работающих запросов задают настройки планировщика, поэтому запрос не запускает своих потоков
+    parallel::ScopedThreadLimit limit(1);
+    while(true){
+        Task task;
+        bool is_heavy = false;
+        bool is_write = false;
+        {
+            std::unique_lock lock(mutex_);
+            auto can_write = [this]{
+                return !write_tasks_.empty() && !write_running_ && heavy_running_ < max_heavy_running_;
+            };
+            cv_.wait(lock, [&]{
+                return stopping_ || !light_tasks_.empty() || can_write()
+                       || (!heavy_tasks_.empty() && heavy_running_ < max_heavy_running_);
+            });
+            if(stopping_){
+                return;
+            }
+            if(!light_tasks_.empty()){
+                task = std::move(light_tasks_.front());
+                light_tasks_.pop_front();
+            }else if(can_write()){
+                task = std::move(write_tasks_.front());
+                write_tasks_.pop_front();
+                ++heavy_running_;
+                write_running_ = true;
+                is_heavy = true;
+                is_write = true;
+            }else{
+                task = std::move(heavy_tasks_.front());
+                heavy_tasks_.pop_front();
+                ++heavy_running_;
+                is_heavy = true;
+            }
+        }
+
+        task.job(task.deadline && Clock::now() > *task.deadline);
+
+        if(is_heavy){
+            {
+                std::lock_guard lock(mutex_);
+                --heavy_running_;
+                if(is_write){
+                    write_running_ = false;
+                }
+            }
+            cv_.notify_all();
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace transport_catalogue{
+namespace server{
+
+enum class CostClass{
+    LIGHT,
+    HEAVY,
+    // изменения каталога выполняются по одному в порядке поступления и занимают место тяжёлого запроса
+    WRITE,
+};
+
+struct SchedulerSettings{
+    int workers = 4;
+    int max_heavy_running = 2;
+};
+
+class RequestScheduler{
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+    using Job = std::function<void(bool deadline_expired)>;
+
+    explicit RequestScheduler(SchedulerSettings settings);
+    ~RequestScheduler();
+
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    void Submit(CostClass cost, std::optional<Clock::time_point> deadline, Job job);
+
+private:
+    struct Task{
+        std::optional<Clock::time_point> deadline;
+        Job job;
+    };
+
+    void WorkerLoop();
+
+    int max_heavy_running_;
+    int heavy_running_ = 0;
+    bool write_running_ = false;
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task> light_tasks_;
+    std::deque<Task> heavy_tasks_;
+    std::deque<Task> write_tasks_;
+    std::vector<std::thread> workers_;
+};
+
+}
+}
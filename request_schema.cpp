@@ -0,0 +1,146 @@
+#include "request_schema.h"
+
+using namespace std::literals;
+
+namespace transport_catalogue{
+namespace schema{
+
+namespace {
+
+std::string_view GetType(const json::Dict& object){
+    auto it = object.find("type"s);
+    if(it == object.end()){
+        throw std::invalid_argument("Request has no \"type\" field"s);
+    }
+    return it->second.AsString();
+}
+
+std::string_view GetType(const json::compact::Value& object){
+    const json::compact::Value* type = object.Find("type"sv);
+    if(type == nullptr){
+        throw std::invalid_argument("Request has no \"type\" field"s);
+    }
+    return type->AsString();
+}
+
+// строки записываются с длиной, чтобы разделитель внутри значения не склеивал разные запросы
+void AppendKeyValue(std::string& key, std::string_view value){
+    key += '\n';
+    key += std::to_string(value.size());
+    key += ':';
+    key += value;
+}
+
+void AppendKeyValue(std::string& key, int value){
+    key += '\n';
+    key += std::to_string(value);
+}
+
+template <typename Query>
+std::string MakeQueryKey(const Query& query){
+    std::string key(Schema<Query>::name);
+    std::apply([&key, &query](const auto&... field){
+        ((field.key != "id"sv ? AppendKeyValue(key, query.*(field.member)) : void()), ...);
+    }, Schema<Query>::fields);
+    return key;
+}
+
+template <typename Object>
+std::optional<BaseRecord> DecodeBaseRecordImpl(const Object& object){
+    std::string_view type = GetType(object);
+    if(type == Schema<StopRecord>::name){
+        return Decode<StopRecord>(object);
+    }
+    if(type == Schema<BusRecord>::name){
+        return Decode<BusRecord>(object);
+    }
+    return std::nullopt;
+}
+
+template <typename Record, typename Removal>
+void DecodeChange(const json::Dict& object, DeltaRecord& record){
+    if(record.action == DeltaAction::REMOVE){
+        record.change = Decode<Removal>(object);
+    }else{
+        record.change = Decode<Record>(object);
+    }
+}
+
+}
+
+std::optional<BaseRecord> DecodeBaseRecord(const json::Dict& object){
+    return DecodeBaseRecordImpl(object);
+}
+
+std::optional<BaseRecord> DecodeBaseRecord(const json::compact::Value& object){
+    return DecodeBaseRecordImpl(object);
+}
+
+// в отличие от базовых запросов изменение неизвестного типа не пропускается, а отклоняет всю дельту
+DeltaRecord DecodeDeltaRecord(const json::Dict& object){
+    auto action = object.find("action"s);
+    if(action == object.end()){
+        throw std::invalid_argument("Delta record has no \"action\" field"s);
+    }
+    DeltaRecord record;
+    if(action->second.AsString() == "add"s){
+        record.action = DeltaAction::ADD;
+    }else if(action->second.AsString() == "modify"s){
+        record.action = DeltaAction::MODIFY;
+    }else if(action->second.AsString() == "remove"s){
+        record.action = DeltaAction::REMOVE;
+    }else{
+        throw std::invalid_argument("Unknown delta action "s + action->second.AsString());
+    }
+
+    std::string_view type = GetType(object);
+    if(type == Schema<StopRecord>::name){
+        DecodeChange<StopRecord, StopRemoval>(object, record);
+    }else if(type == Schema<BusRecord>::name){
+        DecodeChange<BusRecord, BusRemoval>(object, record);
+    }else if(type == Schema<DistanceRecord>::name){
+        DecodeChange<DistanceRecord, DistanceRemoval>(object, record);
+    }else{
+        throw std::invalid_argument("Unknown delta record type "s + std::string(type));
+    }
+    return record;
+}
+
+std::optional<StatQuery> DecodeStatQuery(const json::Dict& object){
+    std::string_view type = GetType(object);
+    if(type == Schema<BusQuery>::name){
+        return Decode<BusQuery>(object);
+    }
+    if(type == Schema<StopQuery>::name){
+        return Decode<StopQuery>(object);
+    }
+    if(type == Schema<MapQuery>::name){
+        return Decode<MapQuery>(object);
+    }
+    if(type == Schema<StatsQuery>::name){
+        return Decode<StatsQuery>(object);
+    }
+    if(type == Schema<MemoryQuery>::name){
+        return Decode<MemoryQuery>(object);
+    }
+    if(type == Schema<AutocompleteQuery>::name){
+        return Decode<AutocompleteQuery>(object);
+    }
+    if(type == Schema<FuzzySearchQuery>::name){
+        return Decode<FuzzySearchQuery>(object);
+    }
+    if(type == Schema<AnalyticsQuery>::name){
+        return Decode<AnalyticsQuery>(object);
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> QueryKey(const StatQuery& query){
+    if(std::holds_alternative<StatsQuery>(query) || std::holds_alternative<MemoryQuery>(query)){
+        return std::nullopt;
+    }
+    return std::visit([](const auto& typed_query){ return MakeQueryKey(typed_query); }, query);
+}
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,352 @@
+#pragma once
+
+#include "json.h"
+#include "json_compact.h"
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace transport_catalogue{
+namespace schema{
+
+struct StopRecord{
+    std::string_view name;
+    double latitude = 0;
+    double longitude = 0;
+    std::vector<std::pair<std::string_view, int>> road_distances;
+};
+
+struct BusRecord{
+    std::string_view name;
+    std::vector<std::string_view> stops;
+    bool is_roundtrip = false;
+};
+
+struct DistanceRecord{
+    std::string_view from;
+    std::string_view to;
+    int distance = 0;
+};
+
+struct StopRemoval{
+    std::string_view name;
+};
+
+struct BusRemoval{
+    std::string_view name;
+};
+
+struct DistanceRemoval{
+    std::string_view from;
+    std::string_view to;
+};
+
+struct BusQuery{
+    int id = 0;
+    std::string_view name;
+};
+
+struct StopQuery{
+    int id = 0;
+    std::string_view name;
+};
+
+struct MapQuery{
+    int id = 0;
+    std::string_view encoding;
+};
+
+struct StatsQuery{
+    int id = 0;
+};
+
+struct MemoryQuery{
+    int id = 0;
+};
+
+// target - "Stop" или "Bus"; limit ограничивает число имён в ответе
+struct AutocompleteQuery{
+    int id = 0;
+    std::string_view target;
+    std::string_view prefix;
+    int limit = 10;
+};
+
+struct FuzzySearchQuery{
+    int id = 0;
+    std::string_view target;
+    std::string_view name;
+    int limit = 10;
+};
+
+// metric - "network_length", "busiest_stops", "curved_routes" или "shared_segments";
+// limit ограничивает длину списков
+struct AnalyticsQuery{
+    int id = 0;
+    std::string_view metric;
+    int limit = 10;
+};
+
+using BaseRecord = std::variant<StopRecord, BusRecord>;
+
+// add требует, чтобы объекта ещё не было, modify - чтобы он уже был;
+// для Distance обе операции задают расстояние в одну сторону
+enum class DeltaAction{
+    ADD,
+    MODIFY,
+    REMOVE,
+};
+
+struct DeltaRecord{
+    DeltaAction action = DeltaAction::ADD;
+    std::variant<StopRecord, BusRecord, DistanceRecord, StopRemoval, BusRemoval, DistanceRemoval> change;
+};
+
+using StatQuery = std::variant<BusQuery, StopQuery, MapQuery, StatsQuery, MemoryQuery, AutocompleteQuery, FuzzySearchQuery,
+                               AnalyticsQuery>;
+
+template <typename Record, typename T>
+struct Field{
+    std::string_view key;
+    T Record::* member;
+    bool required = true;
+};
+
+template <typename Record>
+struct Schema;
+
+template <>
+struct Schema<StopRecord>{
+    static constexpr std::string_view name = "Stop";
+    static constexpr auto fields = std::make_tuple(
+            Field<StopRecord, std::string_view>{"name", &StopRecord::name},
+            Field<StopRecord, double>{"latitude", &StopRecord::latitude},
+            Field<StopRecord, double>{"longitude", &StopRecord::longitude},
+            Field<StopRecord, std::vector<std::pair<std::string_view, int>>>{"road_distances", &StopRecord::road_distances, false});
+};
+
+template <>
+struct Schema<BusRecord>{
+    static constexpr std::string_view name = "Bus";
+    static constexpr auto fields = std::make_tuple(
+            Field<BusRecord, std::string_view>{"name", &BusRecord::name},
+            Field<BusRecord, std::vector<std::string_view>>{"stops", &BusRecord::stops},
+            Field<BusRecord, bool>{"is_roundtrip", &BusRecord::is_roundtrip});
+};
+
+template <>
+struct Schema<DistanceRecord>{
+    static constexpr std::string_view name = "Distance";
+    static constexpr auto fields = std::make_tuple(
+            Field<DistanceRecord, std::string_view>{"from", &DistanceRecord::from},
+            Field<DistanceRecord, std::string_view>{"to", &DistanceRecord::to},
+            Field<DistanceRecord, int>{"distance", &DistanceRecord::distance});
+};
+
+template <>
+struct Schema<StopRemoval>{
+    static constexpr std::string_view name = "Stop";
+    static constexpr auto fields = std::make_tuple(
+            Field<StopRemoval, std::string_view>{"name", &StopRemoval::name});
+};
+
+template <>
+struct Schema<BusRemoval>{
+    static constexpr std::string_view name = "Bus";
+    static constexpr auto fields = std::make_tuple(
+            Field<BusRemoval, std::string_view>{"name", &BusRemoval::name});
+};
+
+template <>
+struct Schema<DistanceRemoval>{
+    static constexpr std::string_view name = "Distance";
+    static constexpr auto fields = std::make_tuple(
+            Field<DistanceRemoval, std::string_view>{"from", &DistanceRemoval::from},
+            Field<DistanceRemoval, std::string_view>{"to", &DistanceRemoval::to});
+};
+
+template <>
+struct Schema<BusQuery>{
+    static constexpr std::string_view name = "Bus";
+    static constexpr auto fields = std::make_tuple(
+            Field<BusQuery, int>{"id", &BusQuery::id},
+            Field<BusQuery, std::string_view>{"name", &BusQuery::name});
+};
+
+template <>
+struct Schema<StopQuery>{
+    static constexpr std::string_view name = "Stop";
+    static constexpr auto fields = std::make_tuple(
+            Field<StopQuery, int>{"id", &StopQuery::id},
+            Field<StopQuery, std::string_view>{"name", &StopQuery::name});
+};
+
+template <>
+struct Schema<MapQuery>{
+    static constexpr std::string_view name = "Map";
+    static constexpr auto fields = std::make_tuple(
+            Field<MapQuery, int>{"id", &MapQuery::id},
+            Field<MapQuery, std::string_view>{"encoding", &MapQuery::encoding, false});
+};
+
+template <>
+struct Schema<StatsQuery>{
+    static constexpr std::string_view name = "Stats";
+    static constexpr auto fields = std::make_tuple(
+            Field<StatsQuery, int>{"id", &StatsQuery::id});
+};
+
+template <>
+struct Schema<MemoryQuery>{
+    static constexpr std::string_view name = "Memory";
+    static constexpr auto fields = std::make_tuple(
+            Field<MemoryQuery, int>{"id", &MemoryQuery::id});
+};
+
+template <>
+struct Schema<AutocompleteQuery>{
+    static constexpr std::string_view name = "Autocomplete";
+    static constexpr auto fields = std::make_tuple(
+            Field<AutocompleteQuery, int>{"id", &AutocompleteQuery::id},
+            Field<AutocompleteQuery, std::string_view>{"target", &AutocompleteQuery::target},
+            Field<AutocompleteQuery, std::string_view>{"prefix", &AutocompleteQuery::prefix},
+            Field<AutocompleteQuery, int>{"limit", &AutocompleteQuery::limit, false});
+};
+
+template <>
+struct Schema<FuzzySearchQuery>{
+    static constexpr std::string_view name = "FuzzySearch";
+    static constexpr auto fields = std::make_tuple(
+            Field<FuzzySearchQuery, int>{"id", &FuzzySearchQuery::id},
+            Field<FuzzySearchQuery, std::string_view>{"target", &FuzzySearchQuery::target},
+            Field<FuzzySearchQuery, std::string_view>{"name", &FuzzySearchQuery::name},
+            Field<FuzzySearchQuery, int>{"limit", &FuzzySearchQuery::limit, false});
+};
+
+template <>
+struct Schema<AnalyticsQuery>{
+    static constexpr std::string_view name = "Analytics";
+    static constexpr auto fields = std::make_tuple(
+            Field<AnalyticsQuery, int>{"id", &AnalyticsQuery::id},
+            Field<AnalyticsQuery, std::string_view>{"metric", &AnalyticsQuery::metric},
+            Field<AnalyticsQuery, int>{"limit", &AnalyticsQuery::limit, false});
+};
+
+namespace detail{
+
+template <typename Source>
+void DecodeValue(const Source& source, int& value){
+    value = source.AsInt();
+}
+
+template <typename Source>
+void DecodeValue(const Source& source, double& value){
+    value = source.AsDouble();
+}
+
+template <typename Source>
+void DecodeValue(const Source& source, bool& value){
+    value = source.AsBool();
+}
+
+template <typename Source>
+void DecodeValue(const Source& source, std::string_view& value){
+    value = source.AsString();
+}
+
+inline void DecodeValue(const json::Node& source, std::vector<std::string_view>& value){
+    value.clear();
+    value.reserve(source.AsArray().size());
+    for(const json::Node& item : source.AsArray()){
+        value.push_back(item.AsString());
+    }
+}
+
+inline void DecodeValue(const json::compact::Value& source, std::vector<std::string_view>& value){
+    value.clear();
+    value.reserve(source.Size());
+    for(const json::compact::Value& item : source){
+        value.push_back(item.AsString());
+    }
+}
+
+inline void DecodeValue(const json::Node& source, std::vector<std::pair<std::string_view, int>>& value){
+    value.clear();
+    for(const auto& [key, item] : source.AsMap()){
+        value.emplace_back(key, item.AsInt());
+    }
+}
+
+inline void DecodeValue(const json::compact::Value& source, std::vector<std::pair<std::string_view, int>>& value){
+    value.clear();
+    value.reserve(source.Size());
+    for(auto it = source.MembersBegin(); it != source.MembersEnd(); ++it){
+        value.emplace_back(it->key, it->value.AsInt());
+    }
+}
+
+template <typename F>
+void ForEachMember(const json::Dict& source, F&& f){
+    for(const auto& [key, value] : source){
+        f(std::string_view(key), value);
+    }
+}
+
+template <typename F>
+void ForEachMember(const json::compact::Value& source, F&& f){
+    for(auto it = source.MembersBegin(); it != source.MembersEnd(); ++it){
+        f(it->key, it->value);
+    }
+}
+
+template <typename Record, typename Source, size_t... I>
+bool DecodeField(Record& record, std::string_view key, const Source& source, uint32_t& seen, std::index_sequence<I...>){
+    constexpr auto& fields = Schema<Record>::fields;
+    return ((std::get<I>(fields).key == key
+             && (DecodeValue(source, record.*(std::get<I>(fields).member)), seen |= 1u << I, true)) || ...);
+}
+
+template <typename Record, size_t... I>
+void CheckRequired(uint32_t seen, std::index_sequence<I...>){
+    constexpr auto& fields = Schema<Record>::fields;
+    auto check = [seen](const auto& field, size_t index){
+        if(field.required && !(seen & (1u << index))){
+            throw std::invalid_argument(std::string(Schema<Record>::name) + " request has no \""
+                                        + std::string(field.key) + "\" field");
+        }
+    };
+    (check(std::get<I>(fields), I), ...);
+}
+
+}
+
+// каждое поле объекта просматривается один раз и сопоставляется с описанием схемы
+template <typename Record, typename Object>
+Record Decode(const Object& object){
+    using Indices = std::make_index_sequence<std::tuple_size_v<std::decay_t<decltype(Schema<Record>::fields)>>>;
+    Record record{};
+    uint32_t seen = 0;
+    detail::ForEachMember(object, [&record, &seen](std::string_view key, const auto& value){
+        detail::DecodeField(record, key, value, seen, Indices{});
+    });
+    detail::CheckRequired<Record>(seen, Indices{});
+    return record;
+}
+
+std::optional<BaseRecord> DecodeBaseRecord(const json::Dict& object);
+std::optional<BaseRecord> DecodeBaseRecord(const json::compact::Value& object);
+DeltaRecord DecodeDeltaRecord(const json::Dict& object);
+std::optional<StatQuery> DecodeStatQuery(const json::Dict& object);
+// запросы с одинаковым ключом получают одинаковый ответ от одной версии каталога; id в ключ не входит.
+// у Stats и Memory ключа нет: их ответ зависит от момента, когда запрос выполнен
+std::optional<std::string> QueryKey(const StatQuery& query);
+
+}
+}
@@ -0,0 +1,99 @@
+#include "response_cache.h"
+#include "memory_accounting.h"
+
+#include <iterator>
+
+namespace transport_catalogue{
+namespace server{
+
+namespace {
+
+std::atomic<uint64_t> budget = ResponseCache::DEFAULT_BUDGET;
+
+// приблизительный объём ответа в куче: строки и узлы контейнеров
+size_t EstimateSize(const json::Node& node){
+    size_t size = sizeof(json::Node);
+    if(node.IsString()){
+        size += node.AsString().size();
+    }else if(node.IsArray()){
+        for(const json::Node& item : node.AsArray()){
+            size += EstimateSize(item);
+        }
+    }else if(node.IsMap()){
+        for(const auto& [key, value] : node.AsMap()){
+            size += 4 * sizeof(void*) + sizeof(std::string) + key.size() + EstimateSize(value);
+        }
+    }
+    return size;
+}
+
+}
+
+void ResponseCache::SetBudget(uint64_t bytes){
+    budget.store(bytes, std::memory_order_relaxed);
+}
+
+uint64_t ResponseCache::GetBudget(){
+    return budget.load(std::memory_order_relaxed);
+}
+
+ResponseCache::~ResponseCache(){
+    Clear();
+}
+
+std::shared_ptr<const json::Node> ResponseCache::Find(uint64_t version, const std::string& key){
+    std::lock_guard lock(mutex_);
+    if(version != version_){
+        return nullptr;
+    }
+    auto it = index_.find(key);
+    if(it == index_.end()){
+        return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->response;
+}
+
+void ResponseCache::Insert(uint64_t version, std::string key, json::Node response){
+    size_t charge = sizeof(Entry) + 4 * sizeof(void*) + key.size() + EstimateSize(response);
+    auto shared_response = std::make_shared<const json::Node>(std::move(response));
+
+    std::lock_guard lock(mutex_);
+    // ответ по устаревшему снимку никому больше не понадобится
+    if(version < version_){
+        return;
+    }
+    if(version > version_){
+        Clear();
+        version_ = version;
+    }
+    if(index_.count(key)){
+        return;
+    }
+    entries_.push_front(Entry{std::move(key), std::move(shared_response), charge});
+    index_.emplace(entries_.front().key, entries_.begin());
+    bytes_ += charge;
+    memory_accounting::RecordAllocation(memory_accounting::Subsystem::RESPONSE_CACHE, charge);
+
+    // собственный бюджет ограничивает сам кэш, а мягкий бюджет процесса заставляет его уступать память остальным
+    uint64_t limit = GetBudget();
+    while(!entries_.empty() && ((limit != 0 && bytes_ > limit) || memory_accounting::IsOverBudget())){
+        Erase(std::prev(entries_.end()));
+    }
+}
+
+void ResponseCache::Erase(std::list<Entry>::iterator entry){
+    bytes_ -= entry->charge;
+    memory_accounting::RecordDeallocation(memory_accounting::Subsystem::RESPONSE_CACHE, entry->charge);
+    index_.erase(entry->key);
+    entries_.erase(entry);
+}
+
+void ResponseCache::Clear(){
+    while(!entries_.empty()){
+        Erase(entries_.begin());
+    }
+}
+
+}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "json.h"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace transport_catalogue{
+namespace server{
+
+// готовые ответы без request_id для одной версии каталога; с приходом новой версии кэш очищается.
+// вытеснение идёт с самых давно использованных записей, пока объём записей выше собственного бюджета кэша
+// или учтённая память процесса выше мягкого бюджета
+class ResponseCache{
+
+public:
+
+    static constexpr uint64_t DEFAULT_BUDGET = 64u << 20;
+
+    // общий для всех кэшей бюджет в байтах; 0 - без ограничения
+    static void SetBudget(uint64_t bytes);
+    static uint64_t GetBudget();
+
+    ResponseCache() = default;
+    ~ResponseCache();
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    std::shared_ptr<const json::Node> Find(uint64_t version, const std::string& key);
+    void Insert(uint64_t version, std::string key, json::Node response);
+
+private:
+    struct Entry{
+        std::string key;
+        std::shared_ptr<const json::Node> response;
+        size_t charge = 0;
+    };
+
+    void Erase(std::list<Entry>::iterator entry);
+    void Clear();
+
+    std::mutex mutex_;
+    uint64_t version_ = 0;
+    size_t bytes_ = 0;
+    std::list<Entry> entries_;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+};
+
+}
+}
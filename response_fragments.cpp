@@ -0,0 +1,158 @@
+#include "response_fragments.h"
+#include "json_reader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <sstream>
+
+using namespace std::literals;
+
+namespace transport_catalogue{
+
+namespace {
+
+std::atomic<bool> enabled = false;
+
+// фрагменты копируются в страницы этого размера; тело крупнее страницы получает отдельную страницу
+constexpr size_t PAGE_SIZE = 64 * 1024;
+constexpr size_t HEADER_SIZE = 2 * sizeof(uint32_t);
+
+ResponseFragments::Fragment Decode(const char* record){
+    uint32_t size = 0;
+    uint32_t split = 0;
+    std::memcpy(&size, record, sizeof(size));
+    std::memcpy(&split, record + sizeof(size), sizeof(split));
+    const char* body = record + HEADER_SIZE;
+    return {{body, split}, {body + split, size - split}};
+}
+
+std::string_view FormatId(int request_id, char (&buffer)[16]){
+    auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), request_id);
+    return {buffer, static_cast<size_t>(ptr - buffer)};
+}
+
+}
+
+void ResponseFragments::Fragment::Write(int request_id, std::ostream& output) const{
+    char buffer[16];
+    output << head << FormatId(request_id, buffer) << tail;
+}
+
+void ResponseFragments::Fragment::Append(int request_id, std::string& output) const{
+    char buffer[16];
+    output.append(head).append(FormatId(request_id, buffer)).append(tail);
+}
+
+ResponseFragments::ResponseFragments(std::shared_ptr<const TransportCatalogue> catalogue)
+        : catalogue_(std::move(catalogue))
+        , bus_slots_(std::make_unique<std::atomic<const char*>[]>(catalogue_->GetAllBuses().size()))
+        , stop_slots_(std::make_unique<std::atomic<const char*>[]>(catalogue_->GetAllStops().size())){}
+
+void ResponseFragments::SetEnabled(bool value){
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+bool ResponseFragments::IsEnabled(){
+    return enabled.load(std::memory_order_relaxed);
+}
+
+std::string ResponseFragments::Render(const json::Dict& response, size_t& split){
+    std::ostringstream out;
+    out << '{';
+    bool first = true;
+    for(const auto& [key, value] : response){
+        if(!first){
+            out << ", "sv;
+        }
+        first = false;
+        out << '"' << key << "\": "sv;
+        if(key == "request_id"sv){
+            split = static_cast<size_t>(out.tellp());
+        }else{
+            json::PrintNode(value, out);
+        }
+    }
+    out << '}';
+    return out.str();
+}
+
+std::optional<ResponseFragments::Fragment> ResponseFragments::Find(const schema::StatQuery& query) const{
+    if(const auto* bus_query = std::get_if<schema::BusQuery>(&query)){
+        return FindBus(bus_query->name);
+    }
+    if(const auto* stop_query = std::get_if<schema::StopQuery>(&query)){
+        return FindStop(stop_query->name);
+    }
+    return std::nullopt;
+}
+
+std::optional<ResponseFragments::Fragment> ResponseFragments::FindBus(std::string_view busname) const{
+    const Bus* bus = catalogue_->FindBus(busname);
+    if(bus == nullptr){
+        return std::nullopt;
+    }
+    std::atomic<const char*>& slot = bus_slots_[bus->id];
+    if(const char* record = slot.load(std::memory_order_acquire)){
+        return Decode(record);
+    }
+    if(memory_accounting::IsOverBudget()){
+        return std::nullopt;
+    }
+    json::Array response;
+    input::JSONReader(*catalogue_).PrintBusInfo(schema::BusQuery{0, busname}, response);
+    size_t split = 0;
+    std::string body = Render(response.front().AsMap(), split);
+    return Publish(slot, body, split);
+}
+
+std::optional<ResponseFragments::Fragment> ResponseFragments::FindStop(std::string_view stopname) const{
+    const Stop* stop = catalogue_->FindStop(stopname);
+    if(stop == nullptr){
+        return std::nullopt;
+    }
+    std::atomic<const char*>& slot = stop_slots_[stop->id];
+    if(const char* record = slot.load(std::memory_order_acquire)){
+        return Decode(record);
+    }
+    if(memory_accounting::IsOverBudget()){
+        return std::nullopt;
+    }
+    json::Array response;
+    input::JSONReader(*catalogue_).PrintStopInfo(schema::StopQuery{0, stopname}, response);
+    size_t split = 0;
+    std::string body = Render(response.front().AsMap(), split);
+    return Publish(slot, body, split);
+}
+
+// тело отрисовывается без блокировки; если два потока отрисовали один объект, в пул попадает только первое
+std::optional<ResponseFragments::Fragment> ResponseFragments::Publish(std::atomic<const char*>& slot,
+                                                                      const std::string& body, size_t split) const{
+    std::lock_guard lock(mutex_);
+    const char* record = slot.load(std::memory_order_relaxed);
+    if(record == nullptr){
+        record = Store(body, split);
+        slot.store(record, std::memory_order_release);
+    }
+    return Decode(record);
+}
+
+// вызывается под mutex_; страница не растёт дальше зарезервированного, поэтому записи в ней не перемещаются
+const char* ResponseFragments::Store(const std::string& body, size_t split) const{
+    size_t record_size = HEADER_SIZE + body.size();
+    if(pages_.empty() || pages_.back().capacity() - pages_.back().size() < record_size){
+        pages_.emplace_back().reserve(std::max(PAGE_SIZE, record_size));
+    }
+    Page& page = pages_.back();
+    size_t offset = page.size();
+    page.resize(offset + record_size);
+    char* record = page.data() + offset;
+    uint32_t size = static_cast<uint32_t>(body.size());
+    uint32_t head_size = static_cast<uint32_t>(split);
+    std::memcpy(record, &size, sizeof(size));
+    std::memcpy(record + sizeof(size), &head_size, sizeof(head_size));
+    std::memcpy(record + HEADER_SIZE, body.data(), body.size());
+    return record;
+}
+
+}
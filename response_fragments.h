@@ -0,0 +1,71 @@
+#pragma once
+
+#include "memory_accounting.h"
+#include "request_schema.h"
+#include "transport_catalogue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue{
+
+// готовые тела ответов на запросы Bus и Stop для одной версии каталога.
+// тело отрисовывается при первом запросе к объекту и дальше только копируется, request_id вставляется между
+// двумя половинами. фрагменты лежат в пуле страницами и после публикации не перемещаются, поэтому читаются без блокировки
+class ResponseFragments{
+
+public:
+
+    // ответ = head + request_id + tail, байт в байт как при сборке через json::Dict
+    struct Fragment{
+        std::string_view head;
+        std::string_view tail;
+
+        void Write(int request_id, std::ostream& output) const;
+        void Append(int request_id, std::string& output) const;
+    };
+
+    explicit ResponseFragments(std::shared_ptr<const TransportCatalogue> catalogue);
+
+    ResponseFragments(const ResponseFragments&) = delete;
+    ResponseFragments& operator=(const ResponseFragments&) = delete;
+
+    // режим выключен по умолчанию: фрагменты занимают память на каждый запрошенный объект
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+    // печатает ответ так же, как json::PrintValue(Dict), но на месте значения request_id оставляет разрез split
+    static std::string Render(const json::Dict& response, size_t& split);
+
+    // пусто для остальных запросов, неизвестных имён и при превышении мягкого бюджета памяти:
+    // тогда ответ собирается обычным путём
+    std::optional<Fragment> Find(const schema::StatQuery& query) const;
+
+    uint64_t GetVersion() const{
+        return catalogue_->GetVersion();
+    }
+
+private:
+    using Page = std::vector<char, memory_accounting::Allocator<char, memory_accounting::Subsystem::RESPONSE_FRAGMENTS>>;
+    using SlotList = std::unique_ptr<std::atomic<const char*>[]>;
+
+    std::optional<Fragment> FindBus(std::string_view busname) const;
+    std::optional<Fragment> FindStop(std::string_view stopname) const;
+    std::optional<Fragment> Publish(std::atomic<const char*>& slot, const std::string& body, size_t split) const;
+    const char* Store(const std::string& body, size_t split) const;
+
+    std::shared_ptr<const TransportCatalogue> catalogue_;
+    // id объекта -> запись в пуле: длина тела, позиция request_id и само тело
+    SlotList bus_slots_;
+    SlotList stop_slots_;
+    mutable std::mutex mutex_;
+    mutable std::vector<Page> pages_;
+};
+
+}
@@ -1,9 +1,23 @@
 #include "svg.h"
+#include "escape.h"
+#include "instrumentation.h"
+#include "tracing.h"
 
 namespace svg {
 
     using namespace std::literals;
 
+    void* Object::operator new(size_t size) {
+        void* result = ::operator new(size);
+        memory_accounting::RecordAllocation(memory_accounting::Subsystem::SVG, size);
+        return result;
+    }
+
+    void Object::operator delete(void* ptr, size_t size) {
+        memory_accounting::RecordDeallocation(memory_accounting::Subsystem::SVG, size);
+        ::operator delete(ptr);
+    }
+
     void Object::Render(const RenderContext& context) const {
         context.RenderIndent();
         RenderObject(context);
@@ -52,6 +66,9 @@ namespace svg {
     }
 
     void Document::Render(std::ostream &out) const {
+        TC_SCOPED_TIMER(SVG_RENDER);
+        TC_TRACE_SCOPE("svg_render");
+        TC_COUNT(SVG_OBJECTS, objects_.size());
         out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
         out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">" << std::endl;
         for(const auto& obj : objects_) {
@@ -101,7 +118,9 @@ namespace svg {
             out << "\" "sv << "font-family=\""sv << font_family_ << "\""sv;
         if(!font_weight_.empty())
             out << " font-weight=\""sv << font_weight_ << "\""sv;
-        out << ">"sv << EncodeString(data_) << "</text>"sv;
+        out << ">"sv;
+        escape::EscapeXml(data_, out);
+        out << "</text>"sv;
     }
 
     std::ostream& operator<<(std::ostream& stream, const StrokeLineCap& line_cap){
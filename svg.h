@@ -1,5 +1,7 @@
 #pragma once
 
+#include "memory_accounting.h"
+
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -94,6 +96,10 @@ namespace svg {
 
         virtual ~Object() = default;
 
+        // объекты документа создаются через make_unique, поэтому учитываются на уровне класса
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr, size_t size);
+
     private:
         virtual void RenderObject(const RenderContext& context) const = 0;
     };
@@ -200,7 +206,7 @@ namespace svg {
         Polyline& AddPoint(Point point);
     private:
         void RenderObject(const RenderContext& context) const override;
-        std::vector<Point> peaks_;
+        std::vector<Point, memory_accounting::Allocator<Point, memory_accounting::Subsystem::SVG>> peaks_;
     };
 
     class Text : public Object, public PathProps<Text>{
@@ -212,27 +218,6 @@ namespace svg {
         Text& SetFontWeight(std::string font_weight);
         Text& SetData(std::string data);
     private:
-        std::string EncodeString(const std::string& str_to_encode) const {
-            using namespace std;
-            std::string encoded_str;
-            std::map<char, std::string> special_symbols = {
-                    {'"' , "&quot;"s},
-                    {'\'', "&apos;"s},
-                    {'<', "&lt;"s},
-                    {'>', "&gt;"s},
-                    {'&', "&amp;"s}
-            };
-
-            for(size_t i = 0; i < str_to_encode.size(); ++i){
-                if(special_symbols.count(str_to_encode[i])){
-                    encoded_str += special_symbols[str_to_encode[i]];
-                }else{
-                    encoded_str += str_to_encode[i];
-                }
-            }
-            return encoded_str;
-        }
-
         void RenderObject(const RenderContext& context) const override;
 
         Point pos_, offset_;
@@ -245,6 +230,7 @@ namespace svg {
         void AddPtr(std::unique_ptr<Object>&& obj) override;
         void Render(std::ostream& out) const;
     private:
-        std::vector<std::unique_ptr<Object>> objects_;
+        std::vector<std::unique_ptr<Object>,
+                memory_accounting::Allocator<std::unique_ptr<Object>, memory_accounting::Subsystem::SVG>> objects_;
     };
 }
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// проверка в тестах не отключается в Release-сборке, в отличие от assert
+#define TC_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " << #condition << std::endl; \
+            std::exit(1); \
+        } \
+    } while (false)
@@ -0,0 +1,127 @@
+#include "tracing.h"
+#include "escape.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std::literals;
+
+namespace tracing {
+
+    namespace detail {
+        std::atomic<bool> enabled = false;
+    }
+
+    namespace {
+        struct Event {
+            const char* name;
+            char phase;
+            int64_t ts_ns;
+        };
+
+        constexpr size_t CHUNK_SIZE = 4096;
+
+        // в кусок пишет только поток-владелец; count публикуется с release, поэтому читатель видит готовые события
+        struct Chunk {
+            std::array<Event, CHUNK_SIZE> events;
+            std::atomic<size_t> count = 0;
+            std::atomic<Chunk*> next = nullptr;
+        };
+
+        struct ThreadBuffer {
+            explicit ThreadBuffer(size_t thread_id): tid(thread_id) {}
+
+            ~ThreadBuffer() {
+                Chunk* chunk = head.next.load(std::memory_order_relaxed);
+                while (chunk != nullptr) {
+                    Chunk* next = chunk->next.load(std::memory_order_relaxed);
+                    delete chunk;
+                    chunk = next;
+                }
+            }
+
+            size_t tid;
+            Chunk head;
+            Chunk* tail = &head;
+        };
+
+        // буферы переживают свои потоки, чтобы трассу можно было выгрузить после их завершения
+        std::mutex registry_mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> registry;
+        std::atomic<int64_t> start_ns = 0;
+
+        thread_local ThreadBuffer* local_buffer = nullptr;
+
+        int64_t NowNs() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        ThreadBuffer& LocalBuffer() {
+            if (local_buffer == nullptr) {
+                std::lock_guard lock(registry_mutex);
+                registry.push_back(std::make_unique<ThreadBuffer>(registry.size() + 1));
+                local_buffer = registry.back().get();
+            }
+            return *local_buffer;
+        }
+    }
+
+    namespace detail {
+        void Record(const char* name, char phase) {
+            ThreadBuffer& buffer = LocalBuffer();
+            Chunk* chunk = buffer.tail;
+            size_t count = chunk->count.load(std::memory_order_relaxed);
+            if (count == CHUNK_SIZE) {
+                Chunk* next = new Chunk;
+                chunk->next.store(next, std::memory_order_release);
+                buffer.tail = chunk = next;
+                count = 0;
+            }
+            chunk->events[count] = {name, phase, NowNs()};
+            chunk->count.store(count + 1, std::memory_order_release);
+        }
+    }
+
+    void Start() {
+#ifdef TC_ENABLE_TRACING
+        int64_t expected = 0;
+        start_ns.compare_exchange_strong(expected, NowNs());
+        detail::enabled.store(true, std::memory_order_relaxed);
+#endif
+    }
+
+    void Stop() {
+        detail::enabled.store(false, std::memory_order_relaxed);
+    }
+
+    void WriteChromeTrace(std::ostream& out) {
+        const int64_t origin = start_ns.load(std::memory_order_relaxed);
+        std::lock_guard lock(registry_mutex);
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["sv;
+        bool first = true;
+        for (const auto& buffer : registry) {
+            for (const Chunk* chunk = &buffer->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire)) {
+                size_t count = chunk->count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++i) {
+                    const Event& event = chunk->events[i];
+                    out << (first ? "\n"sv : ",\n"sv) << "{\"name\": \""sv;
+                    escape::EscapeJson(event.name, out);
+                    // ts в микросекундах с тремя знаками после точки
+                    int64_t ts_ns = event.ts_ns - origin;
+                    char fraction[4] = {static_cast<char>('0' + ts_ns / 100 % 10), static_cast<char>('0' + ts_ns / 10 % 10),
+                                        static_cast<char>('0' + ts_ns % 10), '\0'};
+                    out << "\", \"ph\": \""sv << event.phase << "\", \"ts\": "sv << ts_ns / 1000 << '.' << fraction
+                        << ", \"pid\": 1, \"tid\": "sv << buffer->tid << '}';
+                    first = false;
+                }
+            }
+        }
+        out << "\n]}\n"sv;
+        out.flush();
+    }
+}
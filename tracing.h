@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <iostream>
+
+namespace tracing {
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+        void Record(const char* name, char phase);
+    }
+
+    inline bool IsEnabled() {
+#ifdef TC_ENABLE_TRACING
+        return detail::enabled.load(std::memory_order_relaxed);
+#else
+        return false;
+#endif
+    }
+
+    void Start();
+    void Stop();
+
+    // события читаются без остановки пишущих потоков: в файл попадает всё, что было опубликовано к моменту вызова
+    void WriteChromeTrace(std::ostream& out);
+
+    // name должен жить до выгрузки трассы; обычно это строковый литерал
+    class Scope {
+    public:
+        explicit Scope(const char* name): name_(IsEnabled() ? name : nullptr) {
+            if (name_ != nullptr) {
+                detail::Record(name_, 'B');
+            }
+        }
+
+        ~Scope() {
+            if (name_ != nullptr) {
+                detail::Record(name_, 'E');
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name_;
+    };
+}
+
+#define TC_TRACE_CONCAT_IMPL(a, b) a##b
+#define TC_TRACE_CONCAT(a, b) TC_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef TC_ENABLE_TRACING
+#define TC_TRACE_SCOPE(name) ::tracing::Scope TC_TRACE_CONCAT(tc_trace_scope_, __LINE__)(name)
+#else
+#define TC_TRACE_SCOPE(name) ((void)0)
+#endif
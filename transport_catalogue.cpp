@@ -1,121 +1,707 @@
 #include "transport_catalogue.h"
+#include "instrumentation.h"
+#include "parallel.h"
 
+#include <algorithm>
 #include <iostream>
-#include <unordered_set>
+#include <stdexcept>
 
 namespace transport_catalogue{
 
+namespace {
+
+template <typename T>
+std::shared_ptr<T> MakeObject(T object) {
+    return std::allocate_shared<T>(memory_accounting::Allocator<T, memory_accounting::Subsystem::CATALOGUE_OBJECTS>(), std::move(object));
+}
+
+// на месте удалённого объекта nullptr, а имя не из множества попадает в чужой слот - оба случая отсекает сверка имени
+template <typename T, typename IdList>
+const T* FindFrozen(const perfect_hash::MinimalPerfectHash& hash, const IdList& ids,
+                    const TransportCatalogue::ObjectList<T>& objects, std::string T::*name, std::string_view key) {
+    if(hash.empty()){
+        return nullptr;
+    }
+    const T* object = objects[ids[hash(key)]].get();
+    return object != nullptr && object->*name == key ? object : nullptr;
+}
+
+template <typename T>
+std::pair<std::vector<std::string_view>, std::vector<uint32_t>> CollectNames(const TransportCatalogue::ObjectList<T>& objects, std::string T::*name) {
+    std::vector<std::string_view> keys;
+    std::vector<uint32_t> key_ids;
+    for(const auto& object : objects){
+        if(object){
+            keys.push_back(object.get()->*name);
+            key_ids.push_back(static_cast<uint32_t>(object->id));
+        }
+    }
+    return {std::move(keys), std::move(key_ids)};
+}
+
+// частей больше, чем потоков, чтобы поток, закончивший раньше, взял ещё одну
+constexpr size_t PARTS_PER_THREAD = 4;
+
+size_t PartCount(size_t count) {
+    return std::min(count, parallel::ThreadCount() * PARTS_PER_THREAD);
+}
+
+template <typename Item, typename Better>
+void KeepTop(std::vector<Item>& items, size_t limit, Better better) {
+    if(items.size() > limit){
+        std::nth_element(items.begin(), items.begin() + limit, items.end(), better);
+        items.resize(limit);
+    }
+}
+
+// collect(part, offer) предлагает кандидатов своей части. кандидаты копятся в небольшом буфере, который
+// время от времени урезается до верха, а в конце верхи частей сливаются
+template <typename Item, typename Collect, typename Better>
+std::vector<Item> ParallelTop(size_t parts, size_t limit, Collect collect, Better better) {
+    std::vector<std::vector<Item>> tops(parts);
+    parallel::ForEachIndex(parts, [&](size_t part){
+        std::vector<Item>& top = tops[part];
+        collect(part, [&top, limit, &better](const Item& item){
+            top.push_back(item);
+            if(top.size() >= 2 * limit + 64){
+                KeepTop(top, limit, better);
+            }
+        });
+        KeepTop(top, limit, better);
+    });
+    std::vector<Item> result;
+    for(const std::vector<Item>& top : tops){
+        result.insert(result.end(), top.begin(), top.end());
+    }
+    KeepTop(result, limit, better);
+    std::sort(result.begin(), result.end(), better);
+    return result;
+}
+
+// маршрут повторно попадает в список перегона, только если проходит его не подряд, поэтому списки короткие
+template <typename IdList>
+int CountDistinct(const IdList& ids) {
+    int count = 0;
+    for(auto it = ids.begin(); it != ids.end(); ++it){
+        if(std::find(ids.begin(), it, *it) == it){
+            ++count;
+        }
+    }
+    return count;
+}
+
+// перегон направлен от остановки, добавленной раньше, чтобы сводки не зависели от порядка хранения
+std::pair<const Stop*, const Stop*> SegmentEnds(const TransportCatalogue::ObjectList<Stop>& stops, std::pair<size_t, size_t> segment) {
+    const Stop* from = stops[segment.first].get();
+    const Stop* to = stops[segment.second].get();
+    return from->input_index < to->input_index ? std::pair{from, to} : std::pair{to, from};
+}
+
+uint64_t StopOrderKey(TransportCatalogue::StopOrder order, Coordinates point, Coordinates min, Coordinates max) {
+    switch(order){
+        case TransportCatalogue::StopOrder::MORTON:
+            return MortonKey(point, min, max);
+        case TransportCatalogue::StopOrder::HILBERT:
+            return HilbertKey(point, min, max);
+        default:
+            return 0;
+    }
+}
+
+template <typename IdList>
+perfect_hash::MinimalPerfectHash BuildFrozen(const std::vector<std::string_view>& keys, const std::vector<uint32_t>& key_ids, IdList& ids) {
+    perfect_hash::MinimalPerfectHash hash(keys);
+    ids.assign(keys.size(), 0);
+    for(size_t i = 0; i < keys.size(); ++i){
+        ids[hash(keys[i])] = key_ids[i];
+    }
+    return hash;
+}
+
+}
+
 void TransportCatalogue::AddStop(std::string_view stopname, const Coordinates coordinates) {
+    if(const Stop* existing = FindStop(stopname)){
+        ReplaceStop(*existing, coordinates);
+        return;
+    }
+    Thaw();
+    std::shared_ptr<const Stop> stop = MakeObject(Stop{std::string(stopname), coordinates, stops_.size(), stop_ids_by_input_.size()});
+    stopname_to_stop_[stop->stopname] = stop.get();
+    buses_to_stop_[stop->stopname];
+    stop_ids_by_input_.push_back(static_cast<uint32_t>(stop->id));
+    stops_.push_back(std::move(stop));
+    components_stale_ = true;
+}
+
+// остановку можно удалить, только когда через неё не проходит ни один маршрут
+void TransportCatalogue::RemoveStop(std::string_view stopname) {
     using namespace std::string_literals;
-    Stop stop{std::string(stopname), coordinates};
-    stops_.push_back(stop);
-    stopname_to_stop_[stops_.back().stopname] = &stops_.back();
-    buses_to_stop_[stops_.back().stopname];
+    const Stop& stop = GetExistingStop(stopname);
+    const BusNameSet& buses = buses_to_stop_.at(stop.stopname);
+    if(!buses.empty()){
+        throw std::invalid_argument("Stop "s + stop.stopname + " is used by bus "s + std::string(*buses.begin()));
+    }
+
+    Thaw();
+    const std::shared_ptr<const Stop> holder = stops_[stop.id];
+    stopname_to_stop_.erase(holder->stopname);
+    buses_to_stop_.erase(holder->stopname);
+    stop_to_component_.erase(holder.get());
+    // удаление остановки редкое, поэтому её расстояния ищутся перебором
+    distances_.EraseIf([&holder](const auto& entry){
+        return entry.first.first == holder->id || entry.first.second == holder->id;
+    });
+    stops_.Set(holder->id, nullptr);
+    components_stale_ = true;
+}
+
+// изменённая остановка становится новым объектом, а прежний остаётся нетронутым в старых версиях каталога,
+// поэтому все ключи и маршруты, которые на него ссылались, переводятся на новый объект
+void TransportCatalogue::ReplaceStop(const Stop& old_stop, Coordinates coordinates) {
+    const std::shared_ptr<const Stop> old_holder = stops_[old_stop.id];
+    const Stop* old_ptr = old_holder.get();
+    std::shared_ptr<const Stop> stop = MakeObject(Stop{old_ptr->stopname, coordinates, old_ptr->id, old_ptr->input_index});
+    stops_.Set(stop->id, stop);
+
+    // ключи-представления смотрят в имя старого объекта, поэтому записи вставляются заново
+    stopname_to_stop_.erase(old_ptr->stopname);
+    stopname_to_stop_.emplace(stop->stopname, stop.get());
+
+    BusNameSet buses = buses_to_stop_.at(old_ptr->stopname);
+    buses_to_stop_.erase(old_ptr->stopname);
+    buses_to_stop_.emplace(stop->stopname, std::move(buses));
+
+    if(auto component = stop_to_component_.find(old_ptr); component != stop_to_component_.end()){
+        int component_id = component->second;
+        stop_to_component_.erase(old_ptr);
+        stop_to_component_.emplace(stop.get(), component_id);
+    }
+
+    // расстояния заданы по id и не меняются, а маршруты находятся по индексу остановки
+    std::vector<const Bus*> affected_buses;
+    for(std::string_view busname : buses_to_stop_.at(stop->stopname)){
+        affected_buses.push_back(FindBus(busname));
+    }
+    for(const Bus* bus : affected_buses){
+        std::shared_ptr<Bus> new_bus = MakeObject(Bus(*bus));
+        std::replace(new_bus->stops.begin(), new_bus->stops.end(), old_ptr, static_cast<const Stop*>(stop.get()));
+        ReplaceBus(*bus, std::move(new_bus));
+    }
 }
 
 const Stop* TransportCatalogue::FindStop(std::string_view stopname) const {
-    if(!stopname_to_stop_.count(stopname)){
-        return {};
+    if(frozen_){
+        return FindFrozen(frozen_->stop_hash, frozen_->stop_ids, stops_, &Stop::stopname, stopname);
     }
-    return stopname_to_stop_.at(stopname);
+    auto it = stopname_to_stop_.find(stopname);
+    return it == stopname_to_stop_.end() ? nullptr : it->second;
+}
+
+const Stop& TransportCatalogue::GetExistingStop(std::string_view stopname) const {
+    using namespace std::string_literals;
+    const Stop* stop = FindStop(stopname);
+    if(stop == nullptr){
+        throw std::invalid_argument("Unknown stop "s + std::string(stopname));
+    }
+    return *stop;
 }
 
 void TransportCatalogue::AddBus(std::string_view busname, const std::vector<json::Node>& stops, bool is_roundtrip) {
-    Bus bus{std::string(busname), {}, is_roundtrip};
-    bus.is_roundtrip = is_roundtrip;
-    bus.stops.reserve(stops.size());
+    std::vector<std::string_view> stopnames;
+    stopnames.reserve(stops.size());
+    for (const json::Node &stop: stops) {
+        stopnames.push_back(stop.AsString());
+    }
+    AddBus(busname, stopnames, is_roundtrip);
+}
 
-    buses_.push_back(bus);
-    auto added_bus = &buses_.back();
-    busname_to_bus_[buses_.back().busname] = added_bus;
+void TransportCatalogue::AddBus(std::string_view busname, const std::vector<std::string_view>& stops, bool is_roundtrip) {
+    const Bus* existing = FindBus(busname);
+    std::shared_ptr<Bus> bus = MakeObject(Bus{std::string(busname), {}, is_roundtrip, existing ? existing->id : buses_.size()});
+    bus->stops.reserve(stops.size());
+    for (std::string_view stop: stops) {
+        bus->stops.push_back(&GetExistingStop(stop));
+    }
+    std::vector<const Stop*> unique_stops = bus->stops;
+    std::sort(unique_stops.begin(), unique_stops.end());
+    bus->unique_stops = std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
 
-    if(!stops.empty()) {
+    if(existing){
+        ReplaceBus(*existing, std::move(bus));
+    }else{
+        Thaw();
+        buses_.push_back(bus);
+        IndexBus(*bus);
+    }
+    components_stale_ = true;
+}
 
-        for (const json::Node &stop: stops) {
-            auto stop_to_add = this->FindStop(stop.AsString());
-            (*added_bus).stops.push_back(stop_to_add);
-            buses_to_stop_[stop_to_add->stopname].insert(added_bus->busname);
+void TransportCatalogue::RemoveBus(std::string_view busname) {
+    using namespace std::string_literals;
+    const Bus* bus = FindBus(busname);
+    if(bus == nullptr){
+        throw std::invalid_argument("Unknown bus "s + std::string(busname));
+    }
+    Thaw();
+    const std::shared_ptr<const Bus> holder = buses_[bus->id];
+    UnindexBus(*holder);
+    buses_.Set(holder->id, nullptr);
+    components_stale_ = true;
+}
+
+void TransportCatalogue::ReplaceBus(const Bus& old_bus, std::shared_ptr<const Bus> new_bus) {
+    const std::shared_ptr<const Bus> old_holder = buses_[old_bus.id];
+    UnindexBus(*old_holder);
+    buses_.Set(new_bus->id, new_bus);
+    IndexBus(*new_bus);
+}
+
+void TransportCatalogue::IndexBus(const Bus& bus) {
+    busname_to_bus_[bus.busname] = &bus;
+    for (const Stop* stop: bus.stops) {
+        buses_to_stop_[stop->stopname].insert(bus.busname);
+    }
+    for (size_t i = 1; i < bus.stops.size(); ++i) {
+        BusIdList& segment_buses = segment_to_buses_[SegmentKey(bus.stops[i - 1], bus.stops[i])];
+        if(segment_buses.empty() || segment_buses.back() != bus.id){
+            segment_buses.push_back(bus.id);
         }
-        AddBusRouteLength(buses_.back().busname, buses_.back().stops);
+    }
+    if(!bus.stops.empty()) {
+        AddBusRouteLength(bus.busname, bus.stops);
     }
 }
 
+// ключи-представления указывают на имя старого объекта, поэтому удаляются до его замены
+void TransportCatalogue::UnindexBus(const Bus& bus) {
+    for (const Stop* stop: bus.stops) {
+        buses_to_stop_[stop->stopname].erase(bus.busname);
+    }
+    for (size_t i = 1; i < bus.stops.size(); ++i) {
+        const std::pair<size_t, size_t> key = SegmentKey(bus.stops[i - 1], bus.stops[i]);
+        BusIdList* segment_buses = segment_to_buses_.FindMutable(key);
+        if(segment_buses == nullptr){
+            continue;
+        }
+        segment_buses->erase(std::remove(segment_buses->begin(), segment_buses->end(), bus.id), segment_buses->end());
+        if(segment_buses->empty()){
+            segment_to_buses_.erase(key);
+        }
+    }
+    busname_to_bus_.erase(bus.busname);
+    busname_to_routelength_.erase(bus.busname);
+    stale_routes_.erase(bus.id);
+}
+
+std::pair<size_t, size_t> TransportCatalogue::SegmentKey(const Stop* stop1, const Stop* stop2) {
+    return std::minmax(stop1->id, stop2->id);
+}
+
 const Bus *TransportCatalogue::FindBus(const std::string_view busname) const {
-    if(!busname_to_bus_.count(busname)){
-        return {};
+    if(frozen_){
+        return FindFrozen(frozen_->bus_hash, frozen_->bus_ids, buses_, &Bus::busname, busname);
     }
-    return busname_to_bus_.at(busname);
+    auto it = busname_to_bus_.find(busname);
+    return it == busname_to_bus_.end() ? nullptr : it->second;
 }
 
+// ответ собирается из готовых полей маршрута без выделения памяти
 const TransportCatalogue::BusInfo TransportCatalogue::GetBusInfo(const std::string_view busname) const{
-    using namespace std::string_literals;
-    if(!busname_to_bus_.count(busname)){
+    const Bus* bus = FindBus(busname);
+    if(bus == nullptr){
         return {};
     }
 
     BusInfo bus_info{};
-    bus_info.busname = std::string(busname);
+    bus_info.busname = bus->busname;
 
-    const Bus* bus = FindBus(busname);
-    auto stops_to_bus = bus->stops;
+    const auto& stops_to_bus = bus->stops;
     bool is_roundtrip = bus->is_roundtrip;
 
     bus_info.stops_on_route = is_roundtrip ? static_cast<int>(stops_to_bus.size())
                                             : static_cast<int>(stops_to_bus.size() * 2 - 1);
 
-    std::unordered_set<const Stop*> unique_stops;
-    unique_stops.insert(stops_to_bus.begin(), stops_to_bus.end());
-    bus_info.unique_stops = static_cast<int>(unique_stops.size());
-    bus_info.route_length = busname_to_routelength_.at(busname).first;
-    bus_info.geo_length = busname_to_routelength_.at(busname).second;
+    bus_info.unique_stops = static_cast<int>(bus->unique_stops);
+    const auto& [route_length, geo_length] = busname_to_routelength_.at(busname);
+    bus_info.route_length = route_length;
+    bus_info.geo_length = geo_length;
     bus_info.is_roundtrip = is_roundtrip;
 
     return bus_info;
 }
 
-const std::set<std::string_view> TransportCatalogue::GetStopInfo(std::string_view stopname) const {
+const TransportCatalogue::BusNameSet& TransportCatalogue::GetStopInfo(std::string_view stopname) const {
     return buses_to_stop_.at(stopname);
 }
 
 bool TransportCatalogue::IsExistingStop(std::string_view stopname) const{
-    return stopname_to_stop_.count(stopname);
+    return FindStop(stopname) != nullptr;
 }
 
 void TransportCatalogue::AddDistances(std::string_view stopname, const json::Dict& distances) {
-    const Stop* stop_from = FindStop(stopname);
     for(const auto& dist_info : distances){
-        const Stop* stop_to = FindStop(dist_info.first);
-        distances_[{stop_from, stop_to}] =  dist_info.second.AsInt();
-        if(!distances_.count({stop_to, stop_from})){
-            distances_[{stop_to, stop_from}] =  dist_info.second.AsInt();
-        }
+        AddDistance(stopname, dist_info.first, dist_info.second.AsInt());
+    }
+}
+
+// расстояние до неизвестной остановки ни на что не влияет, поэтому пропускается
+void TransportCatalogue::AddDistance(std::string_view stopname_from, std::string_view stopname_to, int distance) {
+    const Stop* stop_from = FindStop(stopname_from);
+    const Stop* stop_to = FindStop(stopname_to);
+    if(stop_from == nullptr || stop_to == nullptr){
+        return;
+    }
+    distances_[{stop_from->id, stop_to->id}] = distance;
+    if(auto segment = segment_to_buses_.find(SegmentKey(stop_from, stop_to)); segment != segment_to_buses_.end()){
+        stale_routes_.insert(segment->second.begin(), segment->second.end());
+    }
+}
+
+void TransportCatalogue::RemoveDistance(std::string_view stopname_from, std::string_view stopname_to) {
+    using namespace std::string_literals;
+    const Stop& stop_from = GetExistingStop(stopname_from);
+    const Stop& stop_to = GetExistingStop(stopname_to);
+    if(!distances_.erase({stop_from.id, stop_to.id})){
+        throw std::invalid_argument("No distance from "s + stop_from.stopname + " to "s + stop_to.stopname);
+    }
+    if(auto segment = segment_to_buses_.find(SegmentKey(&stop_from, &stop_to)); segment != segment_to_buses_.end()){
+        stale_routes_.insert(segment->second.begin(), segment->second.end());
     }
 }
 
 int TransportCatalogue::GetDistance(std::string_view stopname1, std::string_view stopname2) const{
     const Stop* stop_from = FindStop(stopname1);
     const Stop* stop_to = FindStop(stopname2);
-    if(!distances_.count({stop_from, stop_to}))
+    if(stop_from == nullptr || stop_to == nullptr)
         return 0;
-    return distances_.at({stop_from,stop_to});
+    return GetDistance(*stop_from, *stop_to);
+}
+
+int TransportCatalogue::GetDistance(const Stop& stop_from, const Stop& stop_to) const{
+    if(auto it = distances_.find(std::pair<size_t, size_t>{stop_from.id, stop_to.id}); it != distances_.end())
+        return it->second;
+    if(auto it = distances_.find(std::pair<size_t, size_t>{stop_to.id, stop_from.id}); it != distances_.end())
+        return it->second;
+    return 0;
 }
 
 void TransportCatalogue::AddBusRouteLength(std::string_view busname, const std::vector<const Stop*>& stops_to_bus) {
+    TC_SCOPED_TIMER(ROUTE_LENGTH);
+    TC_COUNT(ROUTE_SEGMENTS, stops_to_bus.empty() ? 0 : stops_to_bus.size() - 1);
+    auto& [route_length, route_geo_length] = busname_to_routelength_[busname];
+    route_length = 0;
+    route_geo_length = 0;
 
     for(auto to = stops_to_bus.begin(), from = to++; to != stops_to_bus.end(); ++to, ++from){
-        double length = GetDistance((*from)->stopname, (*to)->stopname);
-        double geo_length = ComputeDistance((*from)->coordinates, (*to)->coordinates);
-        busname_to_routelength_[busname].first += length;
-        busname_to_routelength_[busname].second += geo_length;
+        route_length += GetDistance(**from, **to);
+        route_geo_length += ComputeDistance((*from)->coordinates, (*to)->coordinates);
     }
 
     if(!FindBus(busname)->is_roundtrip) {
+        TC_COUNT(ROUTE_SEGMENTS, stops_to_bus.empty() ? 0 : stops_to_bus.size() - 1);
         for (auto to = stops_to_bus.rbegin(), from = to++; to != stops_to_bus.rend(); ++to, ++from) {
-            double length = GetDistance((*from)->stopname, (*to)->stopname);
-            double geo_length = ComputeDistance((*from)->coordinates, (*to)->coordinates);
-            busname_to_routelength_[busname].first += length;
-            busname_to_routelength_[busname].second += geo_length;
+            route_length += GetDistance(**from, **to);
+            route_geo_length += ComputeDistance((*from)->coordinates, (*to)->coordinates);
+        }
+    }
+}
+
+void TransportCatalogue::RecomputeRouteLengths() {
+    for(size_t id : stale_routes_){
+        const Bus& bus = *buses_[id];
+        if(!bus.stops.empty()){
+            AddBusRouteLength(bus.busname, bus.stops);
+        }
+    }
+    stale_routes_.clear();
+}
+
+// id остановок плотные, поэтому лес непересекающихся множеств хранится в векторах, а не в хеш-таблицах
+void TransportCatalogue::ComputeStopComponents() {
+    std::vector<size_t> parent(stops_.size());
+    for(size_t id = 0; id < parent.size(); ++id){
+        parent[id] = id;
+    }
+
+    auto find_root = [&parent](size_t id){
+        size_t root = id;
+        while(parent[root] != root){
+            root = parent[root];
+        }
+        while(parent[id] != root){
+            size_t next = parent[id];
+            parent[id] = root;
+            id = next;
+        }
+        return root;
+    };
+
+    for(const auto& bus : buses_){
+        if(!bus){
+            continue;
+        }
+        for(size_t i = 1; i < bus->stops.size(); ++i){
+            size_t root_from = find_root(bus->stops[i - 1]->id);
+            size_t root_to = find_root(bus->stops[i]->id);
+            if(root_from != root_to){
+                parent[root_to] = root_from;
+            }
+        }
+    }
+
+    // компоненты нумеруются в порядке добавления остановок, чтобы ответы не зависели от хеширования и порядка хранения
+    stop_to_component_.clear();
+    stop_to_component_.reserve(stopname_to_stop_.size());
+    std::vector<int> root_to_component(stops_.size(), -1);
+    int component_count = 0;
+    for(uint32_t id : stop_ids_by_input_){
+        const auto& stop = stops_[id];
+        if(!stop){
+            continue;
+        }
+        int& component = root_to_component[find_root(stop->id)];
+        if(component < 0){
+            component = component_count++;
         }
+        stop_to_component_[stop.get()] = component;
+    }
+    components_stale_ = false;
+}
+
+bool TransportCatalogue::AreComponentsStale() const {
+    return components_stale_;
+}
+
+int TransportCatalogue::GetStopComponent(std::string_view stopname) const {
+    return stop_to_component_.at(&GetExistingStop(stopname));
+}
+
+bool TransportCatalogue::AreConnected(std::string_view stopname1, std::string_view stopname2) const {
+    const Stop* stop_from = FindStop(stopname1);
+    const Stop* stop_to = FindStop(stopname2);
+    if(stop_from == nullptr || stop_to == nullptr){
+        return false;
+    }
+    return stop_to_component_.at(stop_from) == stop_to_component_.at(stop_to);
+}
+// новые объекты создаются в новом порядке, поэтому и в памяти соседние остановки оказываются рядом.
+// прежние объекты не меняются и остаются в старых версиях каталога; имена маршрутов в индексах
+// указывают на новые объекты маршрутов, поэтому индексы по именам строятся заново
+void TransportCatalogue::ReorderStops(StopOrder order) {
+    Coordinates min{0, 0};
+    Coordinates max{0, 0};
+    bool first = true;
+    for(const auto& stop : stops_){
+        if(!stop){
+            continue;
+        }
+        const Coordinates& point = stop->coordinates;
+        if(first){
+            min = max = point;
+            first = false;
+        }
+        min = {std::min(min.lat, point.lat), std::min(min.lng, point.lng)};
+        max = {std::max(max.lat, point.lat), std::max(max.lng, point.lng)};
+    }
+
+    // при равных ключах сохраняется порядок добавления; слоты удалённых остановок идут после живых
+    std::vector<std::pair<uint64_t, uint32_t>> live;
+    std::vector<uint32_t> removed;
+    live.reserve(stopname_to_stop_.size());
+    for(uint32_t input_index = 0; input_index < stop_ids_by_input_.size(); ++input_index){
+        if(const Stop* stop = stops_[stop_ids_by_input_[input_index]].get()){
+            live.emplace_back(StopOrderKey(order, stop->coordinates, min, max), input_index);
+        }else{
+            removed.push_back(input_index);
+        }
+    }
+    std::sort(live.begin(), live.end());
+    std::vector<uint32_t> new_order;
+    new_order.reserve(stop_ids_by_input_.size());
+    for(const auto& [key, input_index] : live){
+        new_order.push_back(input_index);
+    }
+    new_order.insert(new_order.end(), removed.begin(), removed.end());
+
+    std::vector<size_t> new_ids(stops_.size());
+    ObjectList<Stop> stops;
+    stops.reserve(stops_.size());
+    for(uint32_t input_index : new_order){
+        size_t old_id = stop_ids_by_input_[input_index];
+        new_ids[old_id] = stops.size();
+        stop_ids_by_input_.Set(input_index, static_cast<uint32_t>(stops.size()));
+        const Stop* old_stop = stops_[old_id].get();
+        stops.push_back(old_stop ? MakeObject(Stop{old_stop->stopname, old_stop->coordinates, stops.size(), input_index}) : nullptr);
+    }
+    auto new_stop = [&](const Stop* old_stop){
+        return static_cast<const Stop*>(stops[new_ids[old_stop->id]].get());
+    };
+
+    decltype(distances_) distances;
+    distances.reserve(distances_.size());
+    for(const auto& [ids, distance] : distances_){
+        distances.emplace({new_ids[ids.first], new_ids[ids.second]}, distance);
     }
+    decltype(segment_to_buses_) segment_to_buses;
+    segment_to_buses.reserve(segment_to_buses_.size());
+    for(const auto& [ids, bus_ids] : segment_to_buses_){
+        segment_to_buses.emplace(std::minmax(new_ids[ids.first], new_ids[ids.second]), bus_ids);
+    }
+    decltype(stop_to_component_) stop_to_component;
+    stop_to_component.reserve(stop_to_component_.size());
+    for(const auto& [stop, component] : stop_to_component_){
+        stop_to_component.emplace(new_stop(stop), component);
+    }
+
+    ObjectList<Bus> buses;
+    buses.reserve(buses_.size());
+    decltype(busname_to_routelength_) busname_to_routelength;
+    busname_to_routelength.reserve(busname_to_routelength_.size());
+    for(const auto& bus : buses_){
+        if(!bus){
+            buses.push_back(nullptr);
+            continue;
+        }
+        std::shared_ptr<Bus> moved = MakeObject(Bus(*bus));
+        for(const Stop*& stop : moved->stops){
+            stop = new_stop(stop);
+        }
+        if(auto lengths = busname_to_routelength_.find(bus->busname); lengths != busname_to_routelength_.end()){
+            busname_to_routelength.emplace(moved->busname, lengths->second);
+        }
+        buses.push_back(std::move(moved));
+    }
+
+    stopname_to_stop_.clear();
+    stopname_to_stop_.reserve(stops.size());
+    buses_to_stop_.clear();
+    buses_to_stop_.reserve(stops.size());
+    for(const auto& stop : stops){
+        if(stop){
+            stopname_to_stop_.emplace(stop->stopname, stop.get());
+            buses_to_stop_[stop->stopname];
+        }
+    }
+    busname_to_bus_.clear();
+    busname_to_bus_.reserve(buses.size());
+    for(const auto& bus : buses){
+        if(!bus){
+            continue;
+        }
+        busname_to_bus_.emplace(bus->busname, bus.get());
+        for(const Stop* stop : bus->stops){
+            buses_to_stop_[stop->stopname].insert(bus->busname);
+        }
+    }
+    if(frozen_){
+        auto frozen = std::make_shared<FrozenNames>(*frozen_);
+        for(uint32_t& id : frozen->stop_ids){
+            id = static_cast<uint32_t>(new_ids[id]);
+        }
+        frozen_ = std::move(frozen);
+    }
+
+    stops_ = std::move(stops);
+    buses_ = std::move(buses);
+    distances_ = std::move(distances);
+    segment_to_buses_ = std::move(segment_to_buses);
+    stop_to_component_ = std::move(stop_to_component);
+    busname_to_routelength_ = std::move(busname_to_routelength);
+}
+
+void TransportCatalogue::Freeze() {
+    if(frozen_){
+        return;
+    }
+    auto frozen = std::make_shared<FrozenNames>();
+    const auto [stop_names, stop_ids] = CollectNames(stops_, &Stop::stopname);
+    frozen->stop_hash = BuildFrozen(stop_names, stop_ids, frozen->stop_ids);
+    frozen->stop_index = name_search::NameIndex(stop_names);
+    const auto [bus_names, bus_ids] = CollectNames(buses_, &Bus::busname);
+    frozen->bus_hash = BuildFrozen(bus_names, bus_ids, frozen->bus_ids);
+    frozen->bus_index = name_search::NameIndex(bus_names);
+    frozen_ = std::move(frozen);
+}
+
+bool TransportCatalogue::IsFrozen() const {
+    return frozen_ != nullptr;
+}
+
+const name_search::NameIndex& TransportCatalogue::GetStopNameIndex() const {
+    static const name_search::NameIndex empty;
+    return frozen_ ? frozen_->stop_index : empty;
+}
+
+const name_search::NameIndex& TransportCatalogue::GetBusNameIndex() const {
+    static const name_search::NameIndex empty;
+    return frozen_ ? frozen_->bus_index : empty;
+}
+
+TransportCatalogue::NetworkLength TransportCatalogue::GetNetworkLength() const {
+    size_t parts = PartCount(segment_to_buses_.size());
+    std::vector<int64_t> lengths(parts, 0);
+    parallel::ForEachIndex(parts, [&](size_t part){
+        for(auto it = segment_to_buses_.PartBegin(part, parts); it != segment_to_buses_.PartBegin(part + 1, parts); ++it){
+            const auto [from, to] = SegmentEnds(stops_, it->first);
+            lengths[part] += GetDistance(*from, *to);
+        }
+    });
+    int64_t length = 0;
+    for(int64_t part_length : lengths){
+        length += part_length;
+    }
+    return {length, static_cast<int>(segment_to_buses_.size())};
+}
+
+std::vector<TransportCatalogue::StopRank> TransportCatalogue::GetBusiestStops(size_t limit) const {
+    size_t parts = PartCount(buses_to_stop_.size());
+    return ParallelTop<StopRank>(parts, limit, [&](size_t part, auto offer){
+        for(auto it = buses_to_stop_.PartBegin(part, parts); it != buses_to_stop_.PartBegin(part + 1, parts); ++it){
+            if(!it->second.empty()){
+                offer({it->first, static_cast<int>(it->second.size())});
+            }
+        }
+    }, [](const StopRank& lhs, const StopRank& rhs){
+        return lhs.bus_count != rhs.bus_count ? lhs.bus_count > rhs.bus_count : lhs.stopname < rhs.stopname;
+    });
+}
+
+// у маршрута, все остановки которого в одной точке, кривизны нет, и в список он не попадает
+std::vector<TransportCatalogue::BusRank> TransportCatalogue::GetMostCurvedBuses(size_t limit) const {
+    size_t parts = PartCount(buses_.size());
+    return ParallelTop<BusRank>(parts, limit, [&](size_t part, auto offer){
+        for(size_t id = buses_.size() * part / parts; id < buses_.size() * (part + 1) / parts; ++id){
+            if(!buses_[id]){
+                continue;
+            }
+            auto lengths = busname_to_routelength_.find(buses_[id]->busname);
+            if(lengths != busname_to_routelength_.end() && lengths->second.second > 0){
+                offer({buses_[id]->busname, lengths->second.first / lengths->second.second});
+            }
+        }
+    }, [](const BusRank& lhs, const BusRank& rhs){
+        return lhs.curvature != rhs.curvature ? lhs.curvature > rhs.curvature : lhs.busname < rhs.busname;
+    });
+}
+
+std::vector<TransportCatalogue::SegmentRank> TransportCatalogue::GetMostSharedSegments(size_t limit) const {
+    size_t parts = PartCount(segment_to_buses_.size());
+    return ParallelTop<SegmentRank>(parts, limit, [&](size_t part, auto offer){
+        for(auto it = segment_to_buses_.PartBegin(part, parts); it != segment_to_buses_.PartBegin(part + 1, parts); ++it){
+            const auto [from, to] = SegmentEnds(stops_, it->first);
+            offer({from->stopname, to->stopname, CountDistinct(it->second)});
+        }
+    }, [](const SegmentRank& lhs, const SegmentRank& rhs){
+        if(lhs.bus_count != rhs.bus_count){
+            return lhs.bus_count > rhs.bus_count;
+        }
+        return lhs.from != rhs.from ? lhs.from < rhs.from : lhs.to < rhs.to;
+    });
+}
+
+// готовую функцию и индексы поиска нельзя изменить по одному имени, поэтому до следующей заморозки поиск идёт по обычным индексам
+void TransportCatalogue::Thaw() {
+    frozen_.reset();
+}
 }
-}
\ No newline at end of file
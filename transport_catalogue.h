@@ -3,10 +3,14 @@
 #include "geo.h"
 #include "json.h"
 #include "domain.h"
+#include "cow_containers.h"
+#include "memory_accounting.h"
+#include "name_search.h"
+#include "perfect_hash.h"
 
+#include <cstdint>
+#include <memory>
 #include <string>
-#include <deque>
-#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <set>
@@ -16,35 +20,29 @@ namespace transport_catalogue{
 class TransportCatalogue{
 public:
 
-    class StopHasher{
-    public:
-        size_t operator()(const std::string_view stopname) const {
-            return hash_sv(stopname);
-        }
-    private:
-        std::hash<std::string_view> hash_sv;
-    };
-
-    class BusHasher{
-    public:
-        size_t operator()(const std::string_view busname) const {
-            return hash_sv(busname);
-        }
-    private:
-        std::hash<std::string_view> hash_sv;
+    // порядок хранения остановок: по умолчанию - порядок добавления, иначе - вдоль кривой Мортона или Гильберта
+    // по координатам, чтобы соседние на карте остановки лежали рядом в памяти
+    enum class StopOrder{
+        INPUT,
+        MORTON,
+        HILBERT
     };
 
+    // пары задаются id остановок: id не меняется при замене объекта остановки новой версией.
+    // таблица сама перемешивает биты хеша, поэтому достаточно уложить оба id в одно слово
     class PairOfStopsHasher{
     public:
-        size_t operator()(const std::pair<const Stop*, const Stop*>& pair_of_stops) const {
-            return ptr_hasher(pair_of_stops.first) + 37 * ptr_hasher(pair_of_stops.second);
+        size_t operator()(const std::pair<size_t, size_t>& pair_of_stops) const {
+            return (static_cast<uint64_t>(pair_of_stops.first) << 32) ^ pair_of_stops.second;
         }
-    private:
-        std::hash<const void*> ptr_hasher;
     };
 
+    using BusNameSet = std::set<std::string_view, std::less<std::string_view>,
+            memory_accounting::Allocator<std::string_view, memory_accounting::Subsystem::STOP_BUSES_INDEX>>;
+
+    // имя указывает на объект маршрута в каталоге
     struct BusInfo{
-        std::string busname;
+        std::string_view busname;
         int stops_on_route;
         int unique_stops;
         double route_length;
@@ -52,32 +50,143 @@ public:
         bool is_roundtrip;
     };
 
-    const std::deque<Stop>& GetAllStops() const{
+    // строки сводок по сети указывают на имена объектов в каталоге
+    struct StopRank{
+        std::string_view stopname;
+        int bus_count;
+    };
+
+    struct BusRank{
+        std::string_view busname;
+        double curvature;
+    };
+
+    struct SegmentRank{
+        std::string_view from;
+        std::string_view to;
+        int bus_count;
+    };
+
+    struct NetworkLength{
+        int64_t length;
+        int segment_count;
+    };
+
+    template <typename T>
+    using ObjectList = cow_containers::ChunkedVector<std::shared_ptr<const T>,
+            memory_accounting::Allocator<std::shared_ptr<const T>, memory_accounting::Subsystem::CATALOGUE_OBJECTS>>;
+    using StopIdList = cow_containers::ChunkedVector<uint32_t, memory_accounting::Allocator<uint32_t, memory_accounting::Subsystem::CATALOGUE_OBJECTS>>;
+
+    // остановки и маршруты неизменяемы и разделяются между версиями каталога;
+    // id объекта совпадает с его позицией в этих списках, на месте удалённого объекта остаётся nullptr
+    const ObjectList<Stop>& GetAllStops() const{
         return stops_;
     }
 
-    const std::deque<Bus>& GetAllBuses() const{
+    const ObjectList<Bus>& GetAllBuses() const{
         return buses_;
     }
 
+    // номер остановки в порядке добавления -> её id; удалённой остановке соответствует слот с nullptr
+    const StopIdList& GetStopIdsInInputOrder() const{
+        return stop_ids_by_input_;
+    }
+
+    uint64_t GetVersion() const{
+        return version_;
+    }
+
     bool IsExistingStop(std::string_view stopname) const;
     void AddStop(std::string_view stopname, const Coordinates coordinates);
+    void RemoveStop(std::string_view stopname);
     const Stop* FindStop(std::string_view stopname) const;
     void AddBusRouteLength(std::string_view busname, const std::vector<const Stop*>& stops_to_bus);
     void AddBus(std::string_view busname, const std::vector<json::Node>& stops, bool is_roundtrip);
+    void AddBus(std::string_view busname, const std::vector<std::string_view>& stops, bool is_roundtrip);
+    void RemoveBus(std::string_view busname);
     const Bus* FindBus(std::string_view busname) const;
     const BusInfo GetBusInfo(std::string_view busname) const;
-    const std::set<std::string_view> GetStopInfo(std::string_view stopname) const;
+    const BusNameSet& GetStopInfo(std::string_view stopname) const;
     void AddDistances(std::string_view stopname, const json::Dict& distances);
+    void AddDistance(std::string_view stopname_from, std::string_view stopname_to, int distance);
+    void RemoveDistance(std::string_view stopname_from, std::string_view stopname_to);
     int GetDistance(std::string_view stopname1, std::string_view stopname2) const;
+    void ComputeStopComponents();
+    bool AreComponentsStale() const;
+    int GetStopComponent(std::string_view stopname) const;
+    bool AreConnected(std::string_view stopname1, std::string_view stopname2) const;
+    // перенумеровывает остановки в заданном порядке и переводит на новые id и объекты все ссылки на них:
+    // маршруты, расстояния, перегоны и индексы. ответы от порядка хранения не зависят
+    void ReorderStops(StopOrder order);
+    // пересчитывает длины только тех маршрутов, которые проходят через изменённые расстояния
+    void RecomputeRouteLengths();
+    // строит совершенные хеш-функции по именам остановок и маршрутов, после чего FindStop и FindBus делают одну пробу,
+    // и индексы поиска по префиксу и опечаткам. изменение объектов заморозку не снимает,
+    // добавление и удаление имени снимают до следующего вызова, иначе поиск находил бы удалённые имена
+    void Freeze();
+    bool IsFrozen() const;
+    // до заморозки индексы поиска пусты
+    const name_search::NameIndex& GetStopNameIndex() const;
+    const name_search::NameIndex& GetBusNameIndex() const;
+    // сводки по всей сети: данные делятся на части, которые считаются параллельно; из каждой части берётся
+    // её верх, и верхи сливаются. при равенстве выше стоит меньшее по алфавиту имя.
+    // длина сети - сумма дорожных расстояний по перегонам, через которые идёт хотя бы один маршрут,
+    // каждый перегон считается один раз и направлен от остановки, добавленной раньше
+    NetworkLength GetNetworkLength() const;
+    std::vector<StopRank> GetBusiestStops(size_t limit) const;
+    std::vector<BusRank> GetMostCurvedBuses(size_t limit) const;
+    std::vector<SegmentRank> GetMostSharedSegments(size_t limit) const;
 
 private:
-    std::deque<Stop> stops_;
-    std::unordered_map<std::string_view, const Stop*, StopHasher> stopname_to_stop_;
-    std::deque<Bus> buses_;
-    std::unordered_map<std::string_view, const Bus*, BusHasher> busname_to_bus_;
-    std::unordered_map<std::string_view, std::set<std::string_view>, StopHasher> buses_to_stop_;
-    std::unordered_map<std::pair<const Stop*, const Stop*>, int, PairOfStopsHasher> distances_;
-    std::unordered_map<std::string_view, std::pair<double, double>, BusHasher> busname_to_routelength_;
+    friend class VersionedCatalogue;
+
+    // каждый индекс учитывается отдельно, чтобы было видно, какой из них растёт;
+    // строковые ключи ищутся по string_view без временных строк.
+    // копия каталога для новой версии разделяет с предыдущей части индексов и списков объектов,
+    // поэтому изменение копирует только затронутые части
+    template <typename Key, typename Value, typename Hasher, memory_accounting::Subsystem S>
+    using TrackedMap = cow_containers::ShardedMap<Key, Value, Hasher, std::equal_to<>,
+            memory_accounting::Allocator<std::pair<const Key, Value>, S>>;
+    using Subsystem = memory_accounting::Subsystem;
+    using BusIdList = std::vector<size_t, memory_accounting::Allocator<size_t, Subsystem::SEGMENT_INDEX>>;
+    // слот совершенной хеш-функции -> id объекта; имя сверяется по самому объекту
+    using FrozenIdList = std::vector<uint32_t, memory_accounting::Allocator<uint32_t, Subsystem::FROZEN_NAME_INDEX>>;
+
+    // после построения не меняется, поэтому версии каталога разделяют его целиком до следующей заморозки
+    struct FrozenNames{
+        perfect_hash::MinimalPerfectHash stop_hash;
+        FrozenIdList stop_ids;
+        perfect_hash::MinimalPerfectHash bus_hash;
+        FrozenIdList bus_ids;
+        name_search::NameIndex stop_index;
+        name_search::NameIndex bus_index;
+    };
+
+    static std::pair<size_t, size_t> SegmentKey(const Stop* stop1, const Stop* stop2);
+
+    const Stop& GetExistingStop(std::string_view stopname) const;
+    int GetDistance(const Stop& stop_from, const Stop& stop_to) const;
+    void ReplaceStop(const Stop& old_stop, Coordinates coordinates);
+    void ReplaceBus(const Bus& old_bus, std::shared_ptr<const Bus> new_bus);
+    void IndexBus(const Bus& bus);
+    void UnindexBus(const Bus& bus);
+    void Thaw();
+
+    ObjectList<Stop> stops_;
+    StopIdList stop_ids_by_input_;
+    TrackedMap<std::string_view, const Stop*, flat_hash::StringHash, Subsystem::STOP_NAME_INDEX> stopname_to_stop_;
+    ObjectList<Bus> buses_;
+    TrackedMap<std::string_view, const Bus*, flat_hash::StringHash, Subsystem::BUS_NAME_INDEX> busname_to_bus_;
+    TrackedMap<std::string_view, BusNameSet, flat_hash::StringHash, Subsystem::STOP_BUSES_INDEX> buses_to_stop_;
+    // хранятся только заданные явно расстояния, обратное направление берётся из них при отсутствии своего
+    TrackedMap<std::pair<size_t, size_t>, int, PairOfStopsHasher, Subsystem::DISTANCES> distances_;
+    // неупорядоченная пара соседних остановок -> id маршрутов, проходящих между ними
+    TrackedMap<std::pair<size_t, size_t>, BusIdList, PairOfStopsHasher, Subsystem::SEGMENT_INDEX> segment_to_buses_;
+    TrackedMap<std::string_view, std::pair<double, double>, flat_hash::StringHash, Subsystem::ROUTE_LENGTHS> busname_to_routelength_;
+    std::unordered_set<size_t> stale_routes_;
+    TrackedMap<const Stop*, int, std::hash<const Stop*>, Subsystem::COMPONENTS> stop_to_component_;
+    bool components_stale_ = false;
+    std::shared_ptr<const FrozenNames> frozen_;
+    uint64_t version_ = 0;
 };
 }
\ No newline at end of file
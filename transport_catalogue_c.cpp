@@ -0,0 +1,145 @@
+#include "transport_catalogue_c.h"
+
+#include "catalogue_service.h"
+#include "request_handler.h"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace std::string_literals;
+
+struct tc_catalogue{
+    explicit tc_catalogue(std::istream& input): service(input){}
+
+    transport_catalogue::CatalogueService service;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+tc_status SetError(tc_status status, std::string error){
+    last_error = std::move(error);
+    return status;
+}
+
+tc_status CopyToBuffer(const std::string& data, char* buffer, size_t buffer_size, size_t* required_size){
+    if(required_size != nullptr){
+        *required_size = data.size() + 1;
+    }
+    if(buffer == nullptr || buffer_size < data.size() + 1){
+        return SetError(TC_BUFFER_TOO_SMALL, "Buffer is too small"s);
+    }
+    std::memcpy(buffer, data.data(), data.size());
+    buffer[data.size()] = '\0';
+    return TC_OK;
+}
+
+}
+
+extern "C" {
+
+tc_catalogue* tc_catalogue_create(const char* json, size_t json_size){
+    if(json == nullptr){
+        SetError(TC_INVALID_ARGUMENT, "JSON buffer is null"s);
+        return nullptr;
+    }
+    try{
+        std::istringstream input(std::string(json, json_size));
+        return new tc_catalogue(input);
+    }catch(const std::exception& e){
+        SetError(TC_ERROR, e.what());
+        return nullptr;
+    }
+}
+
+void tc_catalogue_destroy(tc_catalogue* catalogue){
+    delete catalogue;
+}
+
+const char* tc_last_error(void){
+    return last_error.c_str();
+}
+
+tc_status tc_query_bus(const tc_catalogue* catalogue, const char* busname, tc_bus_info* info){
+    if(catalogue == nullptr || busname == nullptr || info == nullptr){
+        return SetError(TC_INVALID_ARGUMENT, "Null argument"s);
+    }
+    try{
+        const auto snapshot = catalogue->service.GetCatalogue();
+        const auto& db = *snapshot;
+        if(db.FindBus(busname) == nullptr){
+            return SetError(TC_NOT_FOUND, "not found"s);
+        }
+        auto bus_info = db.GetBusInfo(busname);
+        info->route_length = bus_info.route_length;
+        info->curvature = bus_info.route_length / bus_info.geo_length;
+        info->stop_count = bus_info.stops_on_route;
+        info->unique_stop_count = bus_info.unique_stops;
+        return TC_OK;
+    }catch(const std::exception& e){
+        return SetError(TC_ERROR, e.what());
+    }
+}
+
+tc_status tc_query_stop(const tc_catalogue* catalogue, const char* stopname, tc_stop_info* info,
+                        char* buffer, size_t buffer_size, size_t* required_size){
+    if(catalogue == nullptr || stopname == nullptr || info == nullptr){
+        return SetError(TC_INVALID_ARGUMENT, "Null argument"s);
+    }
+    try{
+        const auto snapshot = catalogue->service.GetCatalogue();
+        const auto& db = *snapshot;
+        if(!db.IsExistingStop(stopname)){
+            return SetError(TC_NOT_FOUND, "not found"s);
+        }
+        std::string buses;
+        int bus_count = 0;
+        for(std::string_view bus : db.GetStopInfo(stopname)){
+            buses += bus;
+            buses += '\0';
+            ++bus_count;
+        }
+        info->bus_count = bus_count;
+        info->component_id = db.GetStopComponent(stopname);
+        // завершающий ноль добавит CopyToBuffer, поэтому последний разделитель убираем
+        if(!buses.empty()){
+            buses.pop_back();
+        }
+        return CopyToBuffer(buses, buffer, buffer_size, required_size);
+    }catch(const std::exception& e){
+        return SetError(TC_ERROR, e.what());
+    }
+}
+
+tc_status tc_render_map(const tc_catalogue* catalogue, char* buffer, size_t buffer_size, size_t* required_size){
+    if(catalogue == nullptr){
+        return SetError(TC_INVALID_ARGUMENT, "Null argument"s);
+    }
+    try{
+        const auto& service = catalogue->service;
+        svg::Document doc = service.GetRenderer().DrawMap(GetBusesOnRoute(*service.GetCatalogue()));
+        std::ostringstream out;
+        doc.Render(out);
+        return CopyToBuffer(out.str(), buffer, buffer_size, required_size);
+    }catch(const std::exception& e){
+        return SetError(TC_ERROR, e.what());
+    }
+}
+
+tc_status tc_query_json(const tc_catalogue* catalogue, const char* request, size_t request_size,
+                        char* buffer, size_t buffer_size, size_t* required_size){
+    if(catalogue == nullptr || request == nullptr){
+        return SetError(TC_INVALID_ARGUMENT, "Null argument"s);
+    }
+    try{
+        std::string response = catalogue->service.GetQueryServer().AnswerLine(std::string(request, request_size));
+        response.pop_back();
+        return CopyToBuffer(response, buffer, buffer_size, required_size);
+    }catch(const std::exception& e){
+        return SetError(TC_ERROR, e.what());
+    }
+}
+
+}
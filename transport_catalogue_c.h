@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tc_catalogue tc_catalogue;
+
+typedef enum tc_status{
+    TC_OK = 0,
+    TC_NOT_FOUND = 1,
+    TC_BUFFER_TOO_SMALL = 2,
+    TC_INVALID_ARGUMENT = 3,
+    TC_ERROR = 4
+} tc_status;
+
+typedef struct tc_bus_info{
+    double route_length;
+    double curvature;
+    int stop_count;
+    int unique_stop_count;
+} tc_bus_info;
+
+typedef struct tc_stop_info{
+    int bus_count;
+    int component_id;
+} tc_stop_info;
+
+/* Строит каталог из JSON-документа с base_requests и render_settings. При ошибке возвращает NULL. */
+tc_catalogue* tc_catalogue_create(const char* json, size_t json_size);
+void tc_catalogue_destroy(tc_catalogue* catalogue);
+
+/* Текст последней ошибки в текущем потоке. */
+const char* tc_last_error(void);
+
+tc_status tc_query_bus(const tc_catalogue* catalogue, const char* busname, tc_bus_info* info);
+
+/* Названия автобусов записываются в buffer подряд, каждое завершается нулевым байтом. */
+tc_status tc_query_stop(const tc_catalogue* catalogue, const char* stopname, tc_stop_info* info,
+                        char* buffer, size_t buffer_size, size_t* required_size);
+
+tc_status tc_render_map(const tc_catalogue* catalogue, char* buffer, size_t buffer_size, size_t* required_size);
+
+/* Отвечает на один stat-запрос в формате JSON. */
+tc_status tc_query_json(const tc_catalogue* catalogue, const char* request, size_t request_size,
+                        char* buffer, size_t buffer_size, size_t* required_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,138 @@
+/* C API проверяется из кода на C: заодно видно, что заголовок компилируется без C++. */
+#include "transport_catalogue_c.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TC_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(1); \
+        } \
+    } while (0)
+
+static const char BASE[] =
+    "{\"base_requests\": ["
+    "{\"type\": \"Stop\", \"name\": \"A\", \"latitude\": 55.6, \"longitude\": 37.2, \"road_distances\": {\"B\": 3000}},"
+    "{\"type\": \"Stop\", \"name\": \"B\", \"latitude\": 55.61, \"longitude\": 37.21, \"road_distances\": {\"C\": 4000}},"
+    "{\"type\": \"Stop\", \"name\": \"C\", \"latitude\": 55.62, \"longitude\": 37.2, \"road_distances\": {}},"
+    "{\"type\": \"Stop\", \"name\": \"Lonely\", \"latitude\": 55.7, \"longitude\": 37.3, \"road_distances\": {}},"
+    "{\"type\": \"Bus\", \"name\": \"1\", \"stops\": [\"A\", \"B\", \"C\"], \"is_roundtrip\": false},"
+    "{\"type\": \"Bus\", \"name\": \"22\", \"stops\": [\"A\", \"B\", \"A\"], \"is_roundtrip\": true}],"
+    "\"render_settings\": {\"width\": 600, \"height\": 400, \"padding\": 50, \"line_width\": 14, \"stop_radius\": 5,"
+    "\"bus_label_font_size\": 20, \"bus_label_offset\": [7, 15], \"stop_label_font_size\": 20, \"stop_label_offset\": [7, -3],"
+    "\"underlayer_color\": [255, 255, 255, 0.85], \"underlayer_width\": 3, \"color_palette\": [\"green\", \"red\"]},"
+    "\"stat_requests\": []}";
+
+static void TestCreateErrors(void) {
+    static const char BROKEN[] = "{\"base_requests\": [";
+    TC_CHECK(tc_catalogue_create(NULL, 0) == NULL);
+    TC_CHECK(strlen(tc_last_error()) > 0);
+    TC_CHECK(tc_catalogue_create(BROKEN, sizeof(BROKEN) - 1) == NULL);
+    TC_CHECK(strlen(tc_last_error()) > 0);
+    tc_catalogue_destroy(NULL);
+}
+
+static void TestQueryBus(const tc_catalogue* catalogue) {
+    tc_bus_info info;
+    TC_CHECK(tc_query_bus(catalogue, "1", &info) == TC_OK);
+    TC_CHECK(info.route_length == 14000.0);
+    TC_CHECK(info.stop_count == 5);
+    TC_CHECK(info.unique_stop_count == 3);
+    TC_CHECK(info.curvature > 1.0);
+
+    TC_CHECK(tc_query_bus(catalogue, "Unknown", &info) == TC_NOT_FOUND);
+    TC_CHECK(strcmp(tc_last_error(), "not found") == 0);
+    TC_CHECK(tc_query_bus(catalogue, NULL, &info) == TC_INVALID_ARGUMENT);
+    TC_CHECK(tc_query_bus(catalogue, "1", NULL) == TC_INVALID_ARGUMENT);
+    TC_CHECK(tc_query_bus(NULL, "1", &info) == TC_INVALID_ARGUMENT);
+}
+
+/* при нехватке места буфер не трогается, а required_size сообщает нужный размер вместе с завершающим нулём */
+static void TestQueryStopBuffer(const tc_catalogue* catalogue) {
+    static const char EXPECTED[] = "1\00022";
+    char buffer[64];
+    size_t required = 0;
+    tc_stop_info info;
+
+    TC_CHECK(tc_query_stop(catalogue, "B", &info, NULL, 0, &required) == TC_BUFFER_TOO_SMALL);
+    TC_CHECK(required == sizeof(EXPECTED));
+    TC_CHECK(info.bus_count == 2);
+
+    memset(buffer, '#', sizeof(buffer));
+    TC_CHECK(tc_query_stop(catalogue, "B", &info, buffer, required - 1, &required) == TC_BUFFER_TOO_SMALL);
+    TC_CHECK(buffer[0] == '#');
+
+    TC_CHECK(tc_query_stop(catalogue, "B", &info, buffer, required, NULL) == TC_OK);
+    TC_CHECK(memcmp(buffer, EXPECTED, sizeof(EXPECTED)) == 0);
+    TC_CHECK(buffer[sizeof(EXPECTED)] == '#');
+
+    TC_CHECK(tc_query_stop(catalogue, "Lonely", &info, buffer, sizeof(buffer), &required) == TC_OK);
+    TC_CHECK(info.bus_count == 0 && required == 1 && buffer[0] == '\0');
+
+    required = 12345;
+    TC_CHECK(tc_query_stop(catalogue, "Unknown", &info, buffer, sizeof(buffer), &required) == TC_NOT_FOUND);
+    TC_CHECK(required == 12345);
+    TC_CHECK(tc_query_stop(catalogue, NULL, &info, buffer, sizeof(buffer), &required) == TC_INVALID_ARGUMENT);
+}
+
+static void TestComponents(const tc_catalogue* catalogue) {
+    tc_stop_info a, c, lonely;
+    size_t required = 0;
+    TC_CHECK(tc_query_stop(catalogue, "A", &a, NULL, 0, &required) == TC_BUFFER_TOO_SMALL);
+    TC_CHECK(tc_query_stop(catalogue, "C", &c, NULL, 0, &required) == TC_BUFFER_TOO_SMALL);
+    TC_CHECK(tc_query_stop(catalogue, "Lonely", &lonely, NULL, 0, &required) == TC_BUFFER_TOO_SMALL);
+    TC_CHECK(a.component_id == c.component_id);
+    TC_CHECK(a.component_id != lonely.component_id);
+}
+
+static void TestRenderMap(const tc_catalogue* catalogue) {
+    size_t required = 0;
+    char* buffer;
+    TC_CHECK(tc_render_map(catalogue, NULL, 0, &required) == TC_BUFFER_TOO_SMALL);
+    TC_CHECK(required > 1);
+    buffer = (char*)malloc(required);
+    TC_CHECK(buffer != NULL);
+    TC_CHECK(tc_render_map(catalogue, buffer, required, NULL) == TC_OK);
+    TC_CHECK(strlen(buffer) + 1 == required);
+    TC_CHECK(strncmp(buffer, "<?xml", 5) == 0);
+    free(buffer);
+}
+
+static void TestQueryJson(const tc_catalogue* catalogue) {
+    static const char UNKNOWN[] = "{\"id\": 7, \"type\": \"Bus\", \"name\": \"Unknown\"}";
+    static const char EXPECTED[] = "{\"error_message\": \"not found\", \"request_id\": 7}";
+    static const char BROKEN[] = "{\"id\": 8, \"type\"";
+    char buffer[256];
+    size_t required = 0;
+
+    TC_CHECK(tc_query_json(catalogue, UNKNOWN, sizeof(UNKNOWN) - 1, buffer, 4, &required) == TC_BUFFER_TOO_SMALL);
+    TC_CHECK(required == sizeof(EXPECTED));
+    TC_CHECK(tc_query_json(catalogue, UNKNOWN, sizeof(UNKNOWN) - 1, buffer, required, &required) == TC_OK);
+    TC_CHECK(strcmp(buffer, EXPECTED) == 0);
+
+    /* ошибка разбора запроса возвращается как JSON-ответ, а не как статус */
+    TC_CHECK(tc_query_json(catalogue, BROKEN, sizeof(BROKEN) - 1, buffer, sizeof(buffer), &required) == TC_OK);
+    TC_CHECK(strstr(buffer, "error_message") != NULL);
+    TC_CHECK(tc_query_json(catalogue, NULL, 0, buffer, sizeof(buffer), &required) == TC_INVALID_ARGUMENT);
+}
+
+int main(void) {
+    tc_catalogue* catalogue;
+    TestCreateErrors();
+    catalogue = tc_catalogue_create(BASE, sizeof(BASE) - 1);
+    if (catalogue == NULL) {
+        fprintf(stderr, "tc_catalogue_create: %s\n", tc_last_error());
+        return 1;
+    }
+    TestQueryBus(catalogue);
+    TestQueryStopBuffer(catalogue);
+    TestComponents(catalogue);
+    TestRenderMap(catalogue);
+    TestQueryJson(catalogue);
+    tc_catalogue_destroy(catalogue);
+    printf("transport_catalogue_c_test: OK\n");
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include "versioned_catalogue.h"
+
+#include <atomic>
+
+namespace transport_catalogue{
+
+VersionedCatalogue::VersionedCatalogue(): current_(std::make_shared<const TransportCatalogue>()){}
+
+std::shared_ptr<const TransportCatalogue> VersionedCatalogue::Current() const{
+    return std::atomic_load(&current_);
+}
+
+std::shared_ptr<const TransportCatalogue> VersionedCatalogue::Update(const std::function<void(TransportCatalogue&)>& change){
+    std::lock_guard lock(writer_mutex_);
+    auto next = std::make_shared<TransportCatalogue>(*Current());
+    change(*next);
+    ++next->version_;
+    std::shared_ptr<const TransportCatalogue> published = std::move(next);
+    std::atomic_store(&current_, published);
+    return published;
+}
+
+}
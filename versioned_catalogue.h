@@ -0,0 +1,30 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace transport_catalogue{
+
+// читатели берут снимок и работают с ним до конца запроса, даже если тем временем опубликована новая версия;
+// писатель меняет копию текущей версии, которая разделяет с ней остановки и маршруты, и публикует её атомарно
+class VersionedCatalogue{
+
+public:
+
+    VersionedCatalogue();
+
+    VersionedCatalogue(const VersionedCatalogue&) = delete;
+    VersionedCatalogue& operator=(const VersionedCatalogue&) = delete;
+
+    std::shared_ptr<const TransportCatalogue> Current() const;
+    std::shared_ptr<const TransportCatalogue> Update(const std::function<void(TransportCatalogue&)>& change);
+
+private:
+    std::shared_ptr<const TransportCatalogue> current_;
+    std::mutex writer_mutex_;
+};
+
+}